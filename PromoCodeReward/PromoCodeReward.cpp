@@ -11,35 +11,24 @@
 #include <fstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "json.hpp"
 
+// WinMutex, LockGuard and the lock profiler are shared with TribeWarSystem.
+// PROMOCODE_LOCK_PROFILE turns on its profiling switch for this plugin.
+#ifdef PROMOCODE_LOCK_PROFILE
+#define TRIBEWAR_LOCK_PROFILE
+#endif
+#include "../TribeWarSystem/LockProfiler.h"
+#include "../TribeWarSystem/Sync.h"
+
 #pragma comment(lib, "ArkApi.lib")
 
 namespace
 {
-struct WinMutex
-{
-    WinMutex() noexcept
-    {
-        InitializeSRWLock(&lock_);
-    }
-
-    void lock() noexcept
-    {
-        AcquireSRWLockExclusive(&lock_);
-    }
-
-    void unlock() noexcept
-    {
-        ReleaseSRWLockExclusive(&lock_);
-    }
-
-private:
-    SRWLOCK lock_{};
-};
-
-using DataLock = std::lock_guard<WinMutex>;
+// Scoped data_mutex lock; reports its call site in PROMOCODE_LOCK_PROFILE builds.
+using DataLock = LockGuard<WinMutex>;
 
 struct PromoEntry
 {
@@ -59,7 +48,7 @@ struct Config
     std::vector<PromoEntry> promos;
 };
 
-WinMutex data_mutex;
+WinMutex data_mutex{ "data_mutex" };
 Config config;
 // redeemed[normalized_code][steam_id_str] = unix_ts
 std::unordered_map<std::string, std::unordered_map<std::string, int64_t>> redeemed;
@@ -358,6 +347,43 @@ void CmdPromo(AShooterPlayerController* pc, FString* message, EChatSendMode::Typ
     Send(pc, "Промокод принят. Предмет выдан!");
 }
 
+// Admin console / RCON: Promo.Stats prints the data_mutex lock profile.
+std::string LockProfileReport()
+{
+    const auto text = FormatLockProfiles(CollectLockProfiles());
+    if (text.empty())
+        return "data_mutex: lock profiling not built in (define PROMOCODE_LOCK_PROFILE)\n";
+    return text;
+}
+
+void ConsoleCmdStats(APlayerController* player_controller, FString*, bool)
+{
+    auto* pc = static_cast<AShooterPlayerController*>(player_controller);
+    if (!pc || !pc->bIsAdmin()())
+        return;
+
+    const auto text = LockProfileReport();
+    const FString sender(L"Promo");
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+        auto end = text.find('\n', begin);
+        if (end == std::string::npos)
+            end = text.size();
+        const FString line(text.substr(begin, end - begin).c_str());
+        ArkApi::GetApiUtils().SendChatMessage(pc, sender, L"{}", *line);
+        begin = end + 1;
+    }
+}
+
+void RconCmdStats(RCONClientConnection* connection, RCONPacket* packet, UWorld*)
+{
+    if (!connection || !packet)
+        return;
+    FString reply(LockProfileReport().c_str());
+    connection->SendMessageW(packet->Id, 0, &reply);
+}
+
 void Load()
 {
     LoadConfig();
@@ -367,6 +393,8 @@ void Load()
         config.command = "/promo";
 
     ArkApi::GetCommands().AddChatCommand(config.command.c_str(), &CmdPromo);
+    ArkApi::GetCommands().AddConsoleCommand("Promo.Stats", &ConsoleCmdStats);
+    ArkApi::GetCommands().AddRconCommand("Promo.Stats", &RconCmdStats);
 }
 
 void Unload()
@@ -374,6 +402,8 @@ void Unload()
     SaveData();
     if (!config.command.empty())
         ArkApi::GetCommands().RemoveChatCommand(config.command.c_str());
+    ArkApi::GetCommands().RemoveConsoleCommand("Promo.Stats");
+    ArkApi::GetCommands().RemoveRconCommand("Promo.Stats");
 }
 
 } // namespace
@@ -0,0 +1,82 @@
+#include "AbandonedTracker.h"
+
+#include <limits>
+
+namespace
+{
+constexpr int64_t kOpenEnded = (std::numeric_limits<int64_t>::max)();
+}
+
+void AbandonedTracker::Observe(TribeRegistry& registry, int64_t tribe_id, int32_t members)
+{
+    const auto index = registry.Intern(tribe_id);
+    const int32_t previous = registry.member_count[index]; // -1 = unknown / left the table
+    registry.member_count[index] = members;
+    registry.seen_sweep[index] = sweep_;
+
+    if (members == 0)
+    {
+        if (previous != 0)
+        {
+            empty_.insert(index);
+            registry.abandoned_until[index] = kOpenEnded;
+        }
+        return;
+    }
+
+    // A returning tribe may still carry a closing window from its disappearance.
+    if (previous <= 0)
+    {
+        empty_.erase(index);
+        registry.abandoned_until[index] = 0;
+    }
+}
+
+void AbandonedTracker::EndSweep(TribeRegistry& registry, int64_t now)
+{
+    // Empty tribes that were not visited during this sweep are gone from the table:
+    // start their closing window.
+    for (auto it = empty_.begin(); it != empty_.end();)
+    {
+        const auto index = *it;
+        if (registry.seen_sweep[index] == sweep_)
+        {
+            ++it;
+            continue;
+        }
+
+        const int64_t until = now + window_seconds_;
+        registry.abandoned_until[index] = until;
+        registry.member_count[index] = -1;
+        deadlines_.emplace(until, index);
+        it = empty_.erase(it);
+    }
+
+    ++sweep_;
+}
+
+void AbandonedTracker::Expire(TribeRegistry& registry, int64_t now)
+{
+    while (!deadlines_.empty() && deadlines_.top().first <= now)
+    {
+        const auto deadline = deadlines_.top();
+        deadlines_.pop();
+
+        // Stale queue entries (tribe reappeared, window reopened) are skipped.
+        auto& until = registry.abandoned_until[deadline.second];
+        if (until == deadline.first)
+            until = 0;
+    }
+}
+
+void AbandonedTracker::Clear(TribeRegistry& registry)
+{
+    for (size_t i = 0; i < registry.Size(); ++i)
+    {
+        registry.abandoned_until[i] = 0;
+        registry.member_count[i] = -1;
+    }
+    empty_.clear();
+    deadlines_ = {};
+    ++sweep_;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "TribeRegistry.h"
+
+// Abandoned-structure window, driven by member-count changes.
+//
+// The tribe table is scanned incrementally (a batch per tick). Each visited
+// tribe is passed to Observe(); only tribes whose count crossed zero touch the
+// window column. A tribe that is empty while it exists stays open-ended; once it
+// disappears from the table (not seen for a whole sweep) its window closes
+// `window_seconds` later through a deadline queue.
+//
+// State lives in TribeRegistry columns (member_count, seen_sweep,
+// abandoned_until). Not thread-safe; callers guard it with data_mutex.
+class AbandonedTracker
+{
+public:
+    void SetWindow(int32_t window_seconds)
+    {
+        window_seconds_ = window_seconds;
+    }
+
+    void Observe(TribeRegistry& registry, int64_t tribe_id, int32_t members);
+
+    // Called after the scan cursor wrapped past the end of the tribe table.
+    void EndSweep(TribeRegistry& registry, int64_t now);
+
+    // Drops windows whose deadline passed.
+    void Expire(TribeRegistry& registry, int64_t now);
+
+    // Forgets every window and member count (the feature was switched off).
+    void Clear(TribeRegistry& registry);
+
+    static bool IsVulnerable(const TribeRegistry& registry, int64_t tribe_id, int64_t now)
+    {
+        const auto index = registry.Find(tribe_id);
+        return index != kNoTribeIndex && registry.abandoned_until[index] > now;
+    }
+
+private:
+    using Deadline = std::pair<int64_t, TribeIndex>; // (until, tribe index)
+
+    int32_t window_seconds_ = 0;
+    uint32_t sweep_ = 1;
+    std::unordered_set<TribeIndex> empty_; // tribes last seen with zero members
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines_;
+};
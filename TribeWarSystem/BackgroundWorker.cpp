@@ -0,0 +1,150 @@
+#include "BackgroundWorker.h"
+
+void BackgroundWorker::Start()
+{
+    if (running_.load())
+        return;
+
+    mutex_.Lock();
+    stop_requested_ = false;
+    mutex_.Unlock();
+    running_.store(true);
+
+    try
+    {
+        thread_ = std::thread(&BackgroundWorker::Run, this);
+    }
+    catch (...)
+    {
+        // No thread available: fall back to running jobs inline.
+        running_.store(false);
+    }
+}
+
+void BackgroundWorker::Stop()
+{
+    if (!running_.load())
+        return;
+
+    mutex_.Lock();
+    stop_requested_ = true;
+    mutex_.Unlock();
+    wake_.NotifyAll();
+
+    if (thread_.joinable())
+        thread_.join();
+    running_.store(false);
+
+    // Posted between the thread's last pass and running_ going false.
+    std::vector<Job> rest;
+    mutex_.Lock();
+    rest.swap(queue_);
+    mutex_.Unlock();
+    RunInline(rest);
+    RunPeriodic();
+}
+
+void BackgroundWorker::Abandon()
+{
+    running_.store(false);
+    if (thread_.joinable())
+        thread_.detach();
+
+    // The thread may have been ended while holding the lock; then its queue
+    // cannot be reached safely and is dropped.
+    std::vector<Job> rest;
+    if (!mutex_.TryLock())
+        return;
+    rest.swap(queue_);
+    mutex_.Unlock();
+    RunInline(rest);
+    RunPeriodic();
+}
+
+void BackgroundWorker::Post(Job job)
+{
+    if (!job)
+        return;
+
+    if (running_.load())
+    {
+        mutex_.Lock();
+        queue_.push_back(std::move(job));
+        mutex_.Unlock();
+        wake_.NotifyAll();
+        return;
+    }
+
+    try
+    {
+        job();
+    }
+    catch (...)
+    {
+    }
+}
+
+void BackgroundWorker::AddPeriodic(Job task)
+{
+    if (task && !running_.load())
+        periodic_.push_back(std::move(task));
+}
+
+void BackgroundWorker::RunPeriodic()
+{
+    for (auto& task : periodic_)
+    {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+        }
+    }
+}
+
+void BackgroundWorker::RunInline(std::vector<Job>& jobs)
+{
+    for (auto& job : jobs)
+    {
+        try
+        {
+            job();
+        }
+        catch (...)
+        {
+        }
+    }
+    jobs.clear();
+}
+
+void BackgroundWorker::Run()
+{
+    std::vector<Job> local;
+    for (;;)
+    {
+        bool stopping = false;
+        mutex_.Lock();
+        if (periodic_.empty())
+        {
+            while (queue_.empty() && !stop_requested_)
+                wake_.Wait(mutex_);
+        }
+        else if (queue_.empty() && !stop_requested_)
+        {
+            wake_.WaitFor(mutex_, kPeriodicIntervalMs); // a spurious wakeup is just an early pass
+        }
+        local.swap(queue_);
+        stopping = stop_requested_;
+        mutex_.Unlock();
+
+        RunInline(local);
+        RunPeriodic();
+
+        // Jobs posted before Stop() were in the queue taken above; anything
+        // later is drained by Stop() itself.
+        if (stopping)
+            break;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "Sync.h"
+
+// Single background thread for file I/O that must not run on the game thread.
+// Jobs run in the order they were posted. When the worker is not running
+// (before Start or after Stop), Post runs the job inline on the caller.
+//
+// Periodic tasks run after every batch of jobs and at least every
+// kPeriodicIntervalMs, so producers that only need "soon" (log channels) can
+// leave work in their own lock-free queues instead of posting a job each time.
+class BackgroundWorker
+{
+public:
+    using Job = std::function<void()>;
+
+    BackgroundWorker() = default;
+    BackgroundWorker(const BackgroundWorker&) = delete;
+    BackgroundWorker& operator=(const BackgroundWorker&) = delete;
+
+    void Start();
+
+    // Drains queued jobs and joins the thread. Must not run under the loader
+    // lock (DllMain): the exiting thread needs it. The plugin stops the worker
+    // from Plugin_Unload, before FreeLibrary.
+    void Stop();
+
+    // Process exit: the OS has already ended the thread. Runs whatever is
+    // still queued on the caller and lets go of the thread without waiting.
+    void Abandon();
+
+    void Post(Job job);
+
+    // Call before Start. `task` runs on the worker (and once more in Stop and
+    // Abandon); whatever it touches must outlive the thread.
+    void AddPeriodic(Job task);
+
+    bool IsRunning() const
+    {
+        return running_.load();
+    }
+
+private:
+    static constexpr uint32_t kPeriodicIntervalMs = 100;
+
+    void Run();
+    void RunInline(std::vector<Job>& jobs);
+    void RunPeriodic();
+
+    NativeLock mutex_;
+    NativeCondition wake_;       // queue_ got a job or stop_requested_ was set
+    std::vector<Job> queue_;     // guarded by mutex_
+    bool stop_requested_ = false; // guarded by mutex_
+    std::vector<Job> periodic_;   // fixed once the thread runs
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+};
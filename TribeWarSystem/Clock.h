@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Unix seconds for the war engine and the plugin.
+//
+// The plugin uses TickCachedClock: the system time is read once per game tick
+// and shared by every hook, command and timer in that tick. Benchmarks and the
+// simulator use ManualClock, which only moves when told to, so 48 hours of war
+// timers pass in a few calls.
+class IClock
+{
+public:
+    virtual ~IClock() = default;
+    virtual int64_t Now() = 0;
+};
+
+inline int64_t SystemUnixSeconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Reads the system clock on every call.
+class SystemClock final : public IClock
+{
+public:
+    int64_t Now() override
+    {
+        return SystemUnixSeconds();
+    }
+};
+
+// System time cached until the next Refresh(). Refresh from the game tick;
+// Now() may be read from any thread and falls back to the system clock until
+// the first refresh.
+class TickCachedClock final : public IClock
+{
+public:
+    void Refresh()
+    {
+        now_.store(SystemUnixSeconds(), std::memory_order_relaxed);
+    }
+
+    int64_t Now() override
+    {
+        const auto now = now_.load(std::memory_order_relaxed);
+        return now != 0 ? now : SystemUnixSeconds();
+    }
+
+private:
+    std::atomic<int64_t> now_{ 0 };
+};
+
+// Moves only through Set()/Advance(). Starts at a fixed, realistic date so
+// saved records pass the plausibility checks in LoadData.
+class ManualClock final : public IClock
+{
+public:
+    explicit ManualClock(int64_t now = 1700000000)
+        : now_(now)
+    {
+    }
+
+    void Set(int64_t now)
+    {
+        now_.store(now, std::memory_order_relaxed);
+    }
+
+    int64_t Advance(int64_t seconds)
+    {
+        return now_.fetch_add(seconds, std::memory_order_relaxed) + seconds;
+    }
+
+    int64_t Now() override
+    {
+        return now_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> now_;
+};
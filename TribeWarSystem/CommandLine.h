@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// A chat command line split once into whitespace-separated tokens. Tokens are
+// views into the caller's buffer, which must outlive the CommandLine; nothing
+// is copied or allocated. Tokens past kMaxTokens stay reachable through Rest.
+class CommandLine
+{
+public:
+    static constexpr size_t kMaxTokens = 16;
+
+    CommandLine() = default;
+
+    explicit CommandLine(std::wstring_view text)
+        : text_(text)
+    {
+        size_t pos = 0;
+        while (count_ < kMaxTokens)
+        {
+            while (pos < text.size() && IsSpace(text[pos]))
+                ++pos;
+            if (pos == text.size())
+                break;
+            const size_t begin = pos;
+            while (pos < text.size() && !IsSpace(text[pos]))
+                ++pos;
+            tokens_[count_++] = text.substr(begin, pos - begin);
+        }
+    }
+
+    size_t Size() const
+    {
+        return count_;
+    }
+
+    bool Empty() const
+    {
+        return count_ == 0;
+    }
+
+    // Empty view past the last token.
+    std::wstring_view operator[](size_t i) const
+    {
+        return i < count_ ? tokens_[i] : std::wstring_view();
+    }
+
+    // Token `first` through the end of the line, inner spacing kept as typed.
+    std::wstring_view Rest(size_t first) const
+    {
+        if (first >= count_)
+            return std::wstring_view();
+        auto rest = text_.substr(static_cast<size_t>(tokens_[first].data() - text_.data()));
+        while (!rest.empty() && IsSpace(rest.back()))
+            rest.remove_suffix(1);
+        return rest;
+    }
+
+    // The same line without its first `n` tokens.
+    CommandLine Shift(size_t n) const
+    {
+        CommandLine out;
+        out.text_ = text_;
+        for (size_t i = n; i < count_; ++i)
+            out.tokens_[out.count_++] = tokens_[i];
+        return out;
+    }
+
+private:
+    static bool IsSpace(wchar_t c)
+    {
+        return c == L' ' || c == L'\t' || c == L'\r' || c == L'\n';
+    }
+
+    std::wstring_view text_;
+    std::wstring_view tokens_[kMaxTokens];
+    size_t count_ = 0;
+};
+
+// Command and subcommand names are ASCII; player text is compared as typed.
+inline bool EqualsIgnoreCaseAscii(std::wstring_view a, std::wstring_view b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        wchar_t x = a[i];
+        wchar_t y = b[i];
+        if (x >= L'A' && x <= L'Z')
+            x = static_cast<wchar_t>(x - L'A' + L'a');
+        if (y >= L'A' && y <= L'Z')
+            y = static_cast<wchar_t>(y - L'A' + L'a');
+        if (x != y)
+            return false;
+    }
+    return true;
+}
+
+// Decimal digits only, no sign; false on anything else or above `max`.
+inline bool ParseUInt(std::wstring_view token, uint64_t max, uint64_t& out)
+{
+    if (token.empty())
+        return false;
+    uint64_t value = 0;
+    for (const wchar_t c : token)
+    {
+        if (c < L'0' || c > L'9')
+            return false;
+        const auto digit = static_cast<uint64_t>(c - L'0');
+        if (value > (max - digit) / 10)
+            return false;
+        value = value * 10 + digit;
+    }
+    out = value;
+    return true;
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map for 64-bit integer keys (tribe IDs, war IDs, SteamIDs).
+//
+// Entries are stored densely in a vector; a power-of-two array of 8-byte slots
+// (entry index, upper hash bits) is probed linearly and uses backward-shift
+// deletion, so there are no tombstones and no per-entry heap nodes. The slot
+// is taken from the top bits of a Fibonacci hash, which spreads sequential
+// war IDs evenly instead of in runs; the stored hash bits filter probes before
+// an entry's key is compared. Iteration walks the dense entries.
+//
+// Unlike std::unordered_map, insert and erase may move other entries:
+// pointers and iterators are invalidated by any insert or erase.
+template <typename Key, typename Value>
+class FlatHashMap
+{
+    static_assert(std::is_integral<Key>::value && sizeof(Key) == 8, "FlatHashMap is specialized for 64-bit integer keys");
+
+public:
+    using value_type = std::pair<Key, Value>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    FlatHashMap() = default;
+
+    explicit FlatHashMap(size_t expected)
+    {
+        reserve(expected);
+    }
+
+    size_t size() const
+    {
+        return entries_.size();
+    }
+
+    bool empty() const
+    {
+        return entries_.empty();
+    }
+
+    iterator begin()
+    {
+        return entries_.begin();
+    }
+
+    iterator end()
+    {
+        return entries_.end();
+    }
+
+    const_iterator begin() const
+    {
+        return entries_.begin();
+    }
+
+    const_iterator end() const
+    {
+        return entries_.end();
+    }
+
+    void clear()
+    {
+        for (auto& slot : slots_)
+            slot.index = kEmptyIndex;
+        entries_.clear();
+    }
+
+    void reserve(size_t expected)
+    {
+        entries_.reserve(expected);
+        size_t wanted = kMinCapacity;
+        while (wanted * kMaxLoadNum < expected * kMaxLoadDen)
+            wanted *= 2;
+        if (wanted > slots_.size())
+            Rehash(wanted);
+    }
+
+    Value* find(Key key)
+    {
+        const size_t slot = FindSlot(key);
+        return slot == kNotFound ? nullptr : &entries_[slots_[slot].index].second;
+    }
+
+    const Value* find(Key key) const
+    {
+        const size_t slot = FindSlot(key);
+        return slot == kNotFound ? nullptr : &entries_[slots_[slot].index].second;
+    }
+
+    bool contains(Key key) const
+    {
+        return FindSlot(key) != kNotFound;
+    }
+
+    size_t count(Key key) const
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    // Inserts a default-constructed value if the key is missing.
+    Value& operator[](Key key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    std::pair<value_type*, bool> try_emplace(Key key)
+    {
+        if ((entries_.size() + 1) * kMaxLoadDen > slots_.size() * kMaxLoadNum)
+            Rehash(slots_.empty() ? kMinCapacity : slots_.size() * 2);
+
+        const uint32_t tag = Tag(key);
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = Home(tag);; i = (i + 1) & mask)
+        {
+            auto& slot = slots_[i];
+            if (slot.index == kEmptyIndex)
+            {
+                slot.index = static_cast<uint32_t>(entries_.size());
+                slot.tag = tag;
+                entries_.emplace_back(key, Value());
+                return { &entries_.back(), true };
+            }
+            if (slot.tag == tag && entries_[slot.index].first == key)
+                return { &entries_[slot.index], false };
+        }
+    }
+
+    void insert_or_assign(Key key, Value value)
+    {
+        try_emplace(key).first->second = std::move(value);
+    }
+
+    bool erase(Key key)
+    {
+        size_t hole = FindSlot(key);
+        if (hole == kNotFound)
+            return false;
+
+        // Keep entries dense: move the last entry into the erased entry's place.
+        const uint32_t removed = slots_[hole].index;
+        const uint32_t last = static_cast<uint32_t>(entries_.size() - 1);
+        if (removed != last)
+        {
+            slots_[FindSlot(entries_[last].first)].index = removed;
+            entries_[removed] = std::move(entries_[last]);
+        }
+        entries_.pop_back();
+
+        // Backward-shift deletion: pull later slots of the same probe run into the hole.
+        const size_t mask = slots_.size() - 1;
+        for (size_t next = (hole + 1) & mask; slots_[next].index != kEmptyIndex; next = (next + 1) & mask)
+        {
+            const size_t home = Home(slots_[next].tag);
+            // Move the slot if the hole lies on its probe path (cyclically in [home, next)).
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+        }
+        slots_[hole].index = kEmptyIndex;
+        return true;
+    }
+
+    // Heap bytes held by the slot array and the entry vector.
+    size_t memory_bytes() const
+    {
+        return slots_.capacity() * sizeof(Slot) + entries_.capacity() * sizeof(value_type);
+    }
+
+private:
+    static constexpr uint32_t kEmptyIndex = (std::numeric_limits<uint32_t>::max)();
+
+    struct Slot
+    {
+        uint32_t index = kEmptyIndex; // into entries_
+        uint32_t tag = 0;             // top 32 bits of the key's hash
+    };
+
+    static constexpr size_t kMinCapacity = 16;
+    static constexpr size_t kMaxLoadNum = 4; // max load factor 4/5
+    static constexpr size_t kMaxLoadDen = 5;
+    static constexpr size_t kNotFound = (std::numeric_limits<size_t>::max)();
+
+    static uint32_t Tag(Key key)
+    {
+        // Fibonacci hashing: the multiply carries every key bit into the top
+        // bits, and consecutive keys land about 0.62 of the table apart.
+        const uint64_t x = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint32_t>(x >> 32);
+    }
+
+    size_t Home(uint32_t tag) const
+    {
+        return static_cast<size_t>(tag >> tag_shift_);
+    }
+
+    size_t FindSlot(Key key) const
+    {
+        if (slots_.empty())
+            return kNotFound;
+
+        const uint32_t tag = Tag(key);
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = Home(tag);; i = (i + 1) & mask)
+        {
+            const auto& slot = slots_[i];
+            if (slot.index == kEmptyIndex)
+                return kNotFound;
+            if (slot.tag == tag && entries_[slot.index].first == key)
+                return i;
+        }
+    }
+
+    void Rehash(size_t new_capacity)
+    {
+        // Entries grow with the slots, to what fits before the next rehash.
+        entries_.reserve(new_capacity * kMaxLoadNum / kMaxLoadDen);
+        slots_.assign(new_capacity, Slot());
+        tag_shift_ = 32;
+        for (size_t bits = new_capacity; bits > 1; bits >>= 1)
+            --tag_shift_;
+        const size_t mask = new_capacity - 1;
+        for (uint32_t index = 0; index < entries_.size(); ++index)
+        {
+            const uint32_t tag = Tag(entries_[index].first);
+            size_t i = Home(tag);
+            while (slots_[i].index != kEmptyIndex)
+                i = (i + 1) & mask;
+            slots_[i].index = index;
+            slots_[i].tag = tag;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<value_type> entries_;
+    uint32_t tag_shift_ = 32; // 32 - log2(slot count)
+};
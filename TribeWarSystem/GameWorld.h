@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TribeMembers
+{
+    int64_t tribe_id = 0; // canonical
+    int32_t members = 0;
+};
+
+// Everything the war engine needs to know about the running game.
+// The plugin implements it on top of ArkApi; benchmarks and the simulator use SimWorld.
+// Tribe IDs passed in and out are canonical (see CanonicalTribeId).
+class IGameWorld
+{
+public:
+    virtual ~IGameWorld() = default;
+
+    // False until the server finished loading; damage is blocked until then.
+    virtual bool IsReady() = 0;
+
+    virtual bool AreTribesAllied(int64_t tribe_id, int64_t other_id) = 0;
+
+    // At least one member of the tribe is connected.
+    virtual bool IsTribeOnline(int64_t tribe_id) = 0;
+
+    // Tribe table rows, read in batches by the abandoned-tribe scan.
+    virtual int32_t GetTribeCount() = 0;
+    // Appends member counts for rows [begin, end). Unreadable rows are skipped.
+    virtual void ReadTribeMembers(int32_t begin, int32_t end, std::vector<TribeMembers>& out) = 0;
+
+    // Blueprint path of a structure class (opaque handle owned by the world).
+    virtual bool TryGetClassPath(const void* structure_class, std::string& out_path) = 0;
+};
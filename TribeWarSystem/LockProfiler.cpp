@@ -0,0 +1,241 @@
+#include "LockProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+// Live profiles. Only touched when a profiled mutex is created or destroyed
+// and when a report is built, so a spin lock is enough; it cannot be a
+// WinMutex, which would profile itself.
+class ProfileRegistry
+{
+public:
+    template <typename Fn>
+    void With(Fn&& fn)
+    {
+        while (busy_.test_and_set(std::memory_order_acquire))
+        {
+        }
+        fn(profiles_);
+        busy_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag busy_ = ATOMIC_FLAG_INIT;
+    std::vector<LockProfile*> profiles_;
+};
+
+ProfileRegistry& Registry()
+{
+    static ProfileRegistry registry;
+    return registry;
+}
+
+int BucketOf(uint64_t ns)
+{
+    int bucket = 0;
+    if (ns >> 32)
+    {
+        bucket += 32;
+        ns >>= 32;
+    }
+    while (ns >>= 1)
+        ++bucket;
+    return bucket < kLockBuckets ? bucket : kLockBuckets - 1;
+}
+
+// Writers are serialized by the profiled mutex itself.
+void Bump(std::atomic<uint64_t>& value, uint64_t delta)
+{
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void Raise(std::atomic<uint64_t>& value, uint64_t candidate)
+{
+    if (candidate > value.load(std::memory_order_relaxed))
+        value.store(candidate, std::memory_order_relaxed);
+}
+
+uint64_t Load(const std::atomic<uint64_t>& value)
+{
+    return value.load(std::memory_order_relaxed);
+}
+
+// Upper edge of the bucket holding the p-th sample, capped by max_ns.
+uint64_t BucketPercentile(const uint64_t* buckets, uint64_t max_ns, double p)
+{
+    uint64_t total = 0;
+    for (int b = 0; b < kLockBuckets; ++b)
+        total += buckets[b];
+    if (total == 0)
+        return 0;
+
+    const auto rank = static_cast<uint64_t>(p * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < kLockBuckets; ++b)
+    {
+        seen += buckets[b];
+        if (seen >= rank)
+        {
+            const uint64_t upper = uint64_t(1) << (b + 1);
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return max_ns;
+}
+
+double Us(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1000.0;
+}
+}
+
+LockProfile::LockProfile(const char* name)
+    : name_(name)
+{
+    Registry().With([this](std::vector<LockProfile*>& profiles) { profiles.push_back(this); });
+}
+
+LockProfile::~LockProfile()
+{
+    Registry().With([this](std::vector<LockProfile*>& profiles) {
+        profiles.erase(std::remove(profiles.begin(), profiles.end(), this), profiles.end());
+    });
+}
+
+LockSite* LockProfile::FindSite(const char* function, int line)
+{
+    const auto hash = reinterpret_cast<uintptr_t>(function) * 31u + static_cast<uintptr_t>(line);
+    for (int probe = 0; probe < kLockSites - 1; ++probe)
+    {
+        auto& site = sites_[(hash + probe) % (kLockSites - 1)];
+        const auto* owner = site.function.load(std::memory_order_relaxed);
+        if (!owner)
+        {
+            site.line.store(line, std::memory_order_relaxed);
+            site.function.store(function, std::memory_order_release);
+            return &site;
+        }
+        if (owner == function && site.line.load(std::memory_order_relaxed) == line)
+            return &site;
+    }
+
+    auto& overflow = sites_[kLockSites - 1];
+    if (!overflow.function.load(std::memory_order_relaxed))
+        overflow.function.store("(other)", std::memory_order_release);
+    return &overflow;
+}
+
+LockSite* LockProfile::Acquired(const char* function, int line, bool contended, uint64_t wait_ns)
+{
+    auto* site = FindSite(function ? function : "?", line);
+    Bump(acquisitions_, 1);
+    Bump(site->acquisitions, 1);
+    if (contended)
+    {
+        Bump(contended_, 1);
+        Bump(wait_buckets_[BucketOf(wait_ns)], 1);
+        Raise(max_wait_ns_, wait_ns);
+        Bump(site->contended, 1);
+        Bump(site->wait_ns, wait_ns);
+        Raise(site->max_wait_ns, wait_ns);
+    }
+    return site;
+}
+
+void LockProfile::Released(LockSite* site, uint64_t hold_ns)
+{
+    Bump(hold_buckets_[BucketOf(hold_ns)], 1);
+    Raise(max_hold_ns_, hold_ns);
+    if (site)
+        Bump(site->hold_ns, hold_ns);
+}
+
+uint64_t LockSummary::WaitPercentileNs(double p) const
+{
+    return BucketPercentile(wait_buckets, max_wait_ns, p);
+}
+
+uint64_t LockSummary::HoldPercentileNs(double p) const
+{
+    return BucketPercentile(hold_buckets, max_hold_ns, p);
+}
+
+std::vector<LockSummary> CollectLockProfiles()
+{
+    std::vector<LockSummary> locks;
+    Registry().With([&locks](std::vector<LockProfile*>& profiles) {
+        locks.reserve(profiles.size());
+        for (const auto* profile : profiles)
+        {
+            LockSummary out;
+            out.name = profile->name_;
+            out.acquisitions = Load(profile->acquisitions_);
+            out.contended = Load(profile->contended_);
+            out.max_wait_ns = Load(profile->max_wait_ns_);
+            out.max_hold_ns = Load(profile->max_hold_ns_);
+            for (int b = 0; b < kLockBuckets; ++b)
+            {
+                out.wait_buckets[b] = Load(profile->wait_buckets_[b]);
+                out.hold_buckets[b] = Load(profile->hold_buckets_[b]);
+            }
+
+            for (const auto& site : profile->sites_)
+            {
+                const auto* function = site.function.load(std::memory_order_acquire);
+                if (!function)
+                    continue;
+                LockSiteSummary s;
+                s.function = function;
+                s.line = site.line.load(std::memory_order_relaxed);
+                s.acquisitions = Load(site.acquisitions);
+                s.contended = Load(site.contended);
+                s.wait_ns = Load(site.wait_ns);
+                s.max_wait_ns = Load(site.max_wait_ns);
+                s.hold_ns = Load(site.hold_ns);
+                out.sites.push_back(std::move(s));
+            }
+            std::sort(out.sites.begin(), out.sites.end(), [](const LockSiteSummary& a, const LockSiteSummary& b) {
+                if (a.wait_ns != b.wait_ns)
+                    return a.wait_ns > b.wait_ns;
+                return a.acquisitions > b.acquisitions;
+            });
+            locks.push_back(std::move(out));
+        }
+    });
+    return locks;
+}
+
+std::string FormatLockProfiles(const std::vector<LockSummary>& locks, size_t sites_per_lock)
+{
+    if (locks.empty())
+        return std::string();
+
+    std::string text;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-24s %12s %9s %11s %11s %11s %11s %11s %11s\n", "lock", "acquired", "contended",
+                  "wait_p50_us", "wait_p99_us", "wait_max_us", "hold_p50_us", "hold_p99_us", "hold_max_us");
+    text += line;
+    for (const auto& lock : locks)
+    {
+        std::snprintf(line, sizeof(line), "%-24s %12llu %9llu %11.1f %11.1f %11.1f %11.1f %11.1f %11.1f\n", lock.name.c_str(),
+                      static_cast<unsigned long long>(lock.acquisitions), static_cast<unsigned long long>(lock.contended),
+                      Us(lock.WaitPercentileNs(0.50)), Us(lock.WaitPercentileNs(0.99)), Us(lock.max_wait_ns),
+                      Us(lock.HoldPercentileNs(0.50)), Us(lock.HoldPercentileNs(0.99)), Us(lock.max_hold_ns));
+        text += line;
+
+        const size_t shown = (std::min)(sites_per_lock, lock.sites.size());
+        for (size_t i = 0; i < shown; ++i)
+        {
+            const auto& site = lock.sites[i];
+            const double hold_mean = site.acquisitions ? Us(site.hold_ns) / static_cast<double>(site.acquisitions) : 0.0;
+            const std::string where = site.function + ":" + std::to_string(site.line);
+            std::snprintf(line, sizeof(line), "  %-46.46s %10llu %9llu wait_total=%.1f wait_max=%.1f hold_mean=%.1f\n",
+                          where.c_str(), static_cast<unsigned long long>(site.acquisitions),
+                          static_cast<unsigned long long>(site.contended), Us(site.wait_ns), Us(site.max_wait_ns), hold_mean);
+            text += line;
+        }
+    }
+    return text;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lock contention profile for one WinMutex, in builds with TRIBEWAR_LOCK_PROFILE
+// (CMake option, or add the define to the project's preprocessor definitions).
+//
+// Every update happens while the profiled mutex is held, so writers never race
+// each other; readers take relaxed snapshots that may be off by the lock in
+// flight. Call sites come from LockGuard (Sync.h); plain std::lock_guard users
+// show up as "?".
+constexpr int kLockBuckets = 32; // log2(ns): bucket b holds [2^b, 2^(b+1)) ns
+constexpr int kLockSites = 32;   // per mutex; later sites share the last slot
+
+struct LockSite
+{
+    std::atomic<const char*> function{ nullptr };
+    std::atomic<int> line{ 0 };
+    std::atomic<uint64_t> acquisitions{ 0 };
+    std::atomic<uint64_t> contended{ 0 };
+    std::atomic<uint64_t> wait_ns{ 0 };
+    std::atomic<uint64_t> max_wait_ns{ 0 };
+    std::atomic<uint64_t> hold_ns{ 0 };
+};
+
+struct LockSiteSummary
+{
+    std::string function;
+    int line = 0;
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t wait_ns = 0;
+    uint64_t max_wait_ns = 0;
+    uint64_t hold_ns = 0;
+};
+
+struct LockSummary
+{
+    std::string name;
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t max_wait_ns = 0;
+    uint64_t max_hold_ns = 0;
+    uint64_t wait_buckets[kLockBuckets] = {};
+    uint64_t hold_buckets[kLockBuckets] = {};
+    std::vector<LockSiteSummary> sites; // by total wait, then acquisitions
+
+    uint64_t WaitPercentileNs(double p) const;
+    uint64_t HoldPercentileNs(double p) const;
+};
+
+class LockProfile
+{
+public:
+    explicit LockProfile(const char* name);
+    ~LockProfile();
+
+    LockProfile(const LockProfile&) = delete;
+    LockProfile& operator=(const LockProfile&) = delete;
+
+    const char* Name() const
+    {
+        return name_;
+    }
+
+    // Call with the mutex held. `wait_ns` is 0 for uncontended acquisitions.
+    LockSite* Acquired(const char* function, int line, bool contended, uint64_t wait_ns);
+    void Released(LockSite* site, uint64_t hold_ns);
+
+private:
+    friend std::vector<LockSummary> CollectLockProfiles();
+
+    LockSite* FindSite(const char* function, int line);
+
+    const char* name_;
+    std::atomic<uint64_t> acquisitions_{ 0 };
+    std::atomic<uint64_t> contended_{ 0 };
+    std::atomic<uint64_t> max_wait_ns_{ 0 };
+    std::atomic<uint64_t> max_hold_ns_{ 0 };
+    std::atomic<uint64_t> wait_buckets_[kLockBuckets] = {}; // contended acquisitions only
+    std::atomic<uint64_t> hold_buckets_[kLockBuckets] = {};
+    LockSite sites_[kLockSites];
+};
+
+// Every live profiled mutex, in construction order. Empty unless built with
+// TRIBEWAR_LOCK_PROFILE.
+std::vector<LockSummary> CollectLockProfiles();
+
+// Per-mutex table plus the top `sites_per_lock` call sites by wait time.
+std::string FormatLockProfiles(const std::vector<LockSummary>& locks, size_t sites_per_lock = 5);
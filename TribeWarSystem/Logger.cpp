@@ -0,0 +1,311 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+const char* LevelTag(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Debug:
+    case LogLevel::Info: return "";
+    case LogLevel::Warn: return "WARN ";
+    case LogLevel::Error: return "ERROR ";
+    }
+    return "";
+}
+}
+
+void LogArgs::AddText(const char* data, size_t length)
+{
+    if (count >= kMaxArgs)
+        return;
+    length = (std::min)(length, kTextBytes - text_used);
+    if (length > 0)
+        std::memcpy(text + text_used, data, length);
+
+    auto& arg = args[count++];
+    arg.type = Type::Text;
+    arg.text = TextRef{ text_used, static_cast<uint16_t>(length) };
+    text_used = static_cast<uint16_t>(text_used + length);
+}
+
+void LogArgs::AppendTo(std::string& out) const
+{
+    char number[32];
+    int next = 0;
+    for (const char* p = format ? format : ""; *p; ++p)
+    {
+        if (p[0] != '{' || p[1] != '}' || next >= count)
+        {
+            out += *p;
+            continue;
+        }
+        ++p;
+
+        const auto& arg = args[next++];
+        switch (arg.type)
+        {
+        case Type::Int:
+            std::snprintf(number, sizeof(number), "%" PRId64, arg.i);
+            out += number;
+            break;
+        case Type::UInt:
+            std::snprintf(number, sizeof(number), "%" PRIu64, arg.u);
+            out += number;
+            break;
+        case Type::Double:
+            std::snprintf(number, sizeof(number), "%g", arg.d);
+            out += number;
+            break;
+        case Type::Bool:
+            out += arg.u ? "true" : "false";
+            break;
+        case Type::Text:
+            out.append(text + arg.text.offset, arg.text.length);
+            break;
+        case Type::Pointer:
+            std::snprintf(number, sizeof(number), "%p", arg.p);
+            out += number;
+            break;
+        }
+    }
+}
+
+std::atomic<LogChannel::Record*> LogChannel::recycled_{ nullptr };
+std::atomic<size_t> LogChannel::recycled_count_{ 0 };
+std::atomic<LogChannel::RecordCache*> LogChannel::caches_{ nullptr };
+
+// Records and thread caches live until the module is unloaded. Channels are
+// closed (and their queues flushed) by then.
+struct RecordPoolCleanup
+{
+    ~RecordPoolCleanup()
+    {
+        auto* cache = LogChannel::caches_.exchange(nullptr);
+        while (cache)
+        {
+            DeleteList(cache->head);
+            auto* next = cache->next;
+            delete cache;
+            cache = next;
+        }
+        DeleteList(LogChannel::recycled_.exchange(nullptr));
+        LogChannel::recycled_count_.store(0);
+    }
+
+    static void DeleteList(LogChannel::Record* record)
+    {
+        while (record)
+        {
+            auto* next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+} record_pool_cleanup;
+
+LogChannel::Record* LogChannel::AcquireRecord()
+{
+    // Only this thread pops from its cache, and the shared list is only ever
+    // taken whole, so neither side needs a compare-and-swap loop to pop.
+    thread_local RecordCache* cache = []() {
+        auto* created = new RecordCache();
+        created->next = caches_.load(std::memory_order_relaxed);
+        while (!caches_.compare_exchange_weak(created->next, created, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return created;
+    }();
+    if (!cache->head)
+    {
+        cache->head = recycled_.exchange(nullptr, std::memory_order_acquire);
+        size_t taken = 0;
+        for (auto* record = cache->head; record; record = record->next)
+            ++taken;
+        recycled_count_.fetch_sub(taken, std::memory_order_relaxed);
+    }
+    if (!cache->head)
+        return new Record();
+
+    auto* record = cache->head;
+    cache->head = record->next;
+    record->next = nullptr;
+    record->structured = false;
+    record->args.format = nullptr;
+    record->args.count = 0;
+    record->args.text_used = 0;
+    record->text.clear();
+    return record;
+}
+
+void LogChannel::RecycleRecords(Record* first)
+{
+    Record* keep_first = nullptr;
+    Record* keep_last = nullptr;
+    while (first)
+    {
+        auto* record = first;
+        first = record->next;
+        if (recycled_count_.load(std::memory_order_relaxed) >= kMaxRecycledRecords)
+        {
+            delete record;
+            continue;
+        }
+        recycled_count_.fetch_add(1, std::memory_order_relaxed);
+        record->next = keep_first;
+        keep_first = record;
+        if (!keep_last)
+            keep_last = record;
+    }
+    if (!keep_first)
+        return;
+
+    keep_last->next = recycled_.load(std::memory_order_relaxed);
+    while (!recycled_.compare_exchange_weak(keep_last->next, keep_first, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+LogChannel::~LogChannel()
+{
+    // Not recycled: the pool may already be gone when a channel in another
+    // file is destroyed.
+    RecordPoolCleanup::DeleteList(head_.exchange(nullptr));
+}
+
+void LogChannel::Open(std::string path, uint64_t max_bytes, int32_t keep_files)
+{
+    LockGuard<WinMutex> lock(file_mutex_);
+    if (file_.is_open())
+        file_.close();
+    path_ = std::move(path);
+    max_bytes_ = max_bytes;
+    keep_files_ = keep_files;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path_).parent_path(), ec);
+    const auto size = std::filesystem::file_size(path_, ec);
+    file_bytes_ = ec ? 0 : static_cast<uint64_t>(size);
+}
+
+void LogChannel::Write(LogLevel level, std::string message)
+{
+    TraceInstant(name_, message);
+    if (!enabled_.load(std::memory_order_relaxed))
+        return;
+
+    auto* record = AcquireRecord();
+    record->text = std::move(message);
+    Push(record, level);
+}
+
+void LogChannel::Push(Record* record, LogLevel level)
+{
+    if (record->structured && TraceEnabled())
+    {
+        std::string text;
+        record->args.AppendTo(text);
+        TraceInstant(name_, text);
+    }
+    if (!enabled_.load(std::memory_order_relaxed))
+    {
+        record->next = nullptr;
+        RecycleRecords(record);
+        return;
+    }
+
+    record->time = clock_.Now();
+    record->level = level;
+    record->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    // The running worker picks it up on its next periodic pass; `record` may
+    // already be flushed by now, so it is not touched again.
+    if (!worker_.IsRunning())
+        Flush();
+}
+
+void LogChannel::Flush()
+{
+    auto* record = head_.exchange(nullptr, std::memory_order_acquire);
+    if (!record)
+        return;
+
+    // Oldest first.
+    std::vector<Record*> batch;
+    for (; record; record = record->next)
+        batch.push_back(record);
+
+    LockGuard<WinMutex> lock(file_mutex_);
+    try
+    {
+        TraceScope trace("LogChannel::Flush", "io");
+        std::string text;
+        for (auto it = batch.rbegin(); it != batch.rend(); ++it)
+        {
+            text += std::to_string((*it)->time);
+            text += ' ';
+            text += LevelTag((*it)->level);
+            if ((*it)->structured)
+                (*it)->args.AppendTo(text);
+            else
+                text += (*it)->text;
+            text += '\n';
+        }
+
+        if (!path_.empty())
+        {
+            if (max_bytes_ > 0 && file_bytes_ > 0 && file_bytes_ + text.size() > max_bytes_)
+                RotateLocked();
+            if (!file_.is_open())
+                file_.open(path_, std::ios::app | std::ios::binary);
+            if (file_.is_open())
+            {
+                file_.write(text.data(), static_cast<std::streamsize>(text.size()));
+                file_.flush();
+                file_bytes_ += text.size();
+            }
+        }
+    }
+    catch (...)
+    {
+    }
+
+    RecycleRecords(batch.front()); // still linked through `next`
+}
+
+void LogChannel::Close()
+{
+    Flush();
+    LockGuard<WinMutex> lock(file_mutex_);
+    if (file_.is_open())
+        file_.close();
+}
+
+void LogChannel::RotateLocked()
+{
+    if (file_.is_open())
+        file_.close();
+
+    std::error_code ec;
+    if (keep_files_ <= 0)
+    {
+        std::filesystem::remove(path_, ec);
+    }
+    else
+    {
+        std::filesystem::remove(path_ + "." + std::to_string(keep_files_), ec);
+        for (int32_t i = keep_files_ - 1; i >= 1; --i)
+            std::filesystem::rename(path_ + "." + std::to_string(i), path_ + "." + std::to_string(i + 1), ec);
+        std::filesystem::rename(path_, path_ + ".1", ec);
+    }
+    file_bytes_ = 0;
+}
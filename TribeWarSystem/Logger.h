@@ -0,0 +1,283 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+#include "BackgroundWorker.h"
+#include "Clock.h"
+#include "Sync.h"
+#include "Trace.h"
+
+enum class LogLevel : uint8_t
+{
+    Debug,
+    Info,
+    Warn,
+    Error
+};
+
+// Levels below this are compiled out: their call sites expand to nothing.
+#ifndef TRIBEWAR_LOG_MIN_LEVEL
+#define TRIBEWAR_LOG_MIN_LEVEL 0
+#endif
+
+// Raw arguments of a deferred-format log call. The caller only copies values
+// (and the bytes of string arguments) into the record; the flusher turns them
+// into text. `format` uses "{}" placeholders and must be a string literal.
+struct LogArgs
+{
+    static constexpr int kMaxArgs = 16;
+    static constexpr size_t kTextBytes = 192; // string arguments share this, truncated
+
+    enum class Type : uint8_t
+    {
+        Int,
+        UInt,
+        Double,
+        Bool,
+        Text,
+        Pointer
+    };
+
+    struct TextRef
+    {
+        uint16_t offset;
+        uint16_t length;
+    };
+
+    struct Arg
+    {
+        Type type;
+        union
+        {
+            int64_t i;
+            uint64_t u;
+            double d;
+            const void* p;
+            TextRef text;
+        };
+    };
+
+    const char* format = nullptr;
+    uint8_t count = 0;
+    uint16_t text_used = 0;
+    Arg args[kMaxArgs];
+    char text[kTextBytes];
+
+    template <typename T>
+    void Add(const T& value)
+    {
+        using D = std::decay_t<T>;
+        if constexpr (std::is_array_v<T> && (std::is_same_v<D, const char*> || std::is_same_v<D, char*>))
+            AddText(value, std::strlen(value));
+        else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>)
+            AddText(value, value ? std::strlen(value) : 0);
+        else if constexpr (std::is_same_v<D, std::string>)
+            AddText(value.data(), value.size());
+        else
+        {
+            if (count >= kMaxArgs)
+                return;
+            auto& arg = args[count++];
+            if constexpr (std::is_same_v<D, bool>)
+            {
+                arg.type = Type::Bool;
+                arg.u = value ? 1 : 0;
+            }
+            else if constexpr (std::is_enum_v<D>)
+            {
+                arg.type = Type::Int;
+                arg.i = static_cast<int64_t>(value);
+            }
+            else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+            {
+                arg.type = Type::Int;
+                arg.i = static_cast<int64_t>(value);
+            }
+            else if constexpr (std::is_integral_v<D>)
+            {
+                arg.type = Type::UInt;
+                arg.u = static_cast<uint64_t>(value);
+            }
+            else if constexpr (std::is_floating_point_v<D>)
+            {
+                arg.type = Type::Double;
+                arg.d = static_cast<double>(value);
+            }
+            else if constexpr (std::is_pointer_v<D>)
+            {
+                arg.type = Type::Pointer;
+                arg.p = static_cast<const void*>(value);
+            }
+            else
+                static_assert(sizeof(D) == 0, "unsupported log argument type");
+        }
+    }
+
+    void AddText(const char* data, size_t length);
+
+    // Substitutes the arguments into `format`.
+    void AppendTo(std::string& out) const;
+};
+
+// One log file with a lock-free in-memory queue.
+//
+// Write() only pushes a record with one compare-and-swap; the background
+// worker flushes every channel on its periodic pass (BackgroundWorker::
+// AddPeriodic), appending everything queued so far with a single open file.
+// Before the worker starts and after it stops, Write flushes inline. The file is rotated to path.1 .. path.N once it passes
+// max_bytes. While a trace capture runs, every message also becomes a trace
+// instant event, even if the channel itself is disabled.
+//
+// Use the TRIBEWAR_LOG_* macros: the message expression is only evaluated
+// when someone wants it. On hot paths prefer TRIBEWAR_LOGF_*, which defer the
+// formatting itself to the flusher.
+//
+// Records are recycled rather than freed: the flusher hands them back to a
+// shared list, and a writing thread moves that whole list into its own cache
+// when the cache runs dry, so steady logging does not allocate.
+class LogChannel
+{
+public:
+    // `name` is the trace category. `clock` stamps lines; `worker` flushes (inline when it is not running).
+    // Construct before `worker` starts.
+    LogChannel(const char* name, IClock& clock, BackgroundWorker& worker)
+        : name_(name), clock_(clock), worker_(worker)
+    {
+        worker_.AddPeriodic([this]() { Flush(); });
+    }
+
+    ~LogChannel();
+
+    LogChannel(const LogChannel&) = delete;
+    LogChannel& operator=(const LogChannel&) = delete;
+
+    // Call before the first Write. `keep_files` rotated files are kept.
+    void Open(std::string path, uint64_t max_bytes, int32_t keep_files);
+
+    void SetEnabled(bool enabled)
+    {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool Wants() const
+    {
+        return enabled_.load(std::memory_order_relaxed) || TraceEnabled();
+    }
+
+    void Write(LogLevel level, std::string message);
+
+    // Deferred formatting: see LogArgs.
+    template <typename... Args>
+    void WriteFormat(LogLevel level, const char* format, const Args&... args)
+    {
+        auto* record = AcquireRecord();
+        record->structured = true;
+        record->args.format = format;
+        (record->args.Add(args), ...);
+        Push(record, level);
+    }
+
+    // Appends queued records to the file. Runs on the worker; also safe inline.
+    void Flush();
+
+    // Flushes and closes the file (plugin unload, after the worker stopped).
+    void Close();
+
+private:
+    struct Record
+    {
+        Record* next = nullptr;
+        int64_t time = 0;
+        LogLevel level = LogLevel::Info;
+        bool structured = false; // `args` instead of `text`
+        LogArgs args;
+        std::string text;
+    };
+
+    friend struct RecordPoolCleanup;
+
+    // Recycled records a writing thread took from recycled_. Registered once
+    // per thread and freed with the module, like the trace and stat blocks.
+    struct RecordCache
+    {
+        Record* head = nullptr; // owner thread only
+        RecordCache* next = nullptr;
+    };
+
+    // At most this many records wait for reuse; the flusher frees the rest.
+    static constexpr size_t kMaxRecycledRecords = 256;
+
+    // A cleared record from this thread's cache, the shared list, or the heap.
+    static Record* AcquireRecord();
+    // Takes the `next`-linked list starting at `first` back for reuse.
+    static void RecycleRecords(Record* first);
+
+    // Takes ownership: queues the record, or drops it when only a trace wanted it.
+    void Push(Record* record, LogLevel level);
+    void RotateLocked();
+
+    const char* name_;
+    IClock& clock_;
+    BackgroundWorker& worker_;
+    std::atomic<bool> enabled_{ false };
+    std::atomic<Record*> head_{ nullptr }; // newest first
+
+    static std::atomic<Record*> recycled_;      // shared by all channels, taken whole
+    static std::atomic<size_t> recycled_count_; // in recycled_, not in thread caches
+    static std::atomic<RecordCache*> caches_;   // every thread's cache, never unlinked
+
+    WinMutex file_mutex_{ "log_file" }; // flusher only, never taken by Write
+    std::string path_;
+    uint64_t max_bytes_ = 0;
+    int32_t keep_files_ = 0;
+    std::ofstream file_;
+    uint64_t file_bytes_ = 0;
+};
+
+#define TRIBEWAR_LOG_AT(channel, level, ...)        \
+    do                                              \
+    {                                               \
+        if ((channel).Wants())                      \
+            (channel).Write((level), (__VA_ARGS__)); \
+    } while (0)
+
+#if TRIBEWAR_LOG_MIN_LEVEL <= 0
+#define TRIBEWAR_LOG_DEBUG(channel, ...) TRIBEWAR_LOG_AT(channel, LogLevel::Debug, __VA_ARGS__)
+#else
+#define TRIBEWAR_LOG_DEBUG(channel, ...) ((void)0)
+#endif
+
+#if TRIBEWAR_LOG_MIN_LEVEL <= 1
+#define TRIBEWAR_LOG_INFO(channel, ...) TRIBEWAR_LOG_AT(channel, LogLevel::Info, __VA_ARGS__)
+#else
+#define TRIBEWAR_LOG_INFO(channel, ...) ((void)0)
+#endif
+
+#define TRIBEWAR_LOG_WARN(channel, ...) TRIBEWAR_LOG_AT(channel, LogLevel::Warn, __VA_ARGS__)
+
+// Deferred-format variants: TRIBEWAR_LOGF_DEBUG(channel, "{}: use_index={}", hook_name, use_index).
+#define TRIBEWAR_LOGF_AT(channel, level, ...)             \
+    do                                                    \
+    {                                                     \
+        if ((channel).Wants())                            \
+            (channel).WriteFormat((level), __VA_ARGS__);  \
+    } while (0)
+
+#if TRIBEWAR_LOG_MIN_LEVEL <= 0
+#define TRIBEWAR_LOGF_DEBUG(channel, ...) TRIBEWAR_LOGF_AT(channel, LogLevel::Debug, __VA_ARGS__)
+#else
+#define TRIBEWAR_LOGF_DEBUG(channel, ...) ((void)0)
+#endif
+
+#if TRIBEWAR_LOG_MIN_LEVEL <= 1
+#define TRIBEWAR_LOGF_INFO(channel, ...) TRIBEWAR_LOGF_AT(channel, LogLevel::Info, __VA_ARGS__)
+#else
+#define TRIBEWAR_LOGF_INFO(channel, ...) ((void)0)
+#endif
+
+#define TRIBEWAR_LOGF_WARN(channel, ...) TRIBEWAR_LOGF_AT(channel, LogLevel::Warn, __VA_ARGS__)
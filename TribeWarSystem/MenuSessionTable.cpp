@@ -0,0 +1,117 @@
+#include "MenuSessionTable.h"
+
+#include <algorithm>
+
+MenuSessionTable::MenuSessionTable(size_t capacity, int64_t ttl_seconds)
+    : ttl_seconds_(ttl_seconds), slab_((std::max)(capacity, size_t(1))), index_(slab_.size())
+{
+    free_slots_.reserve(slab_.size());
+    for (size_t slot = slab_.size(); slot-- > 0;)
+        free_slots_.push_back(static_cast<uint32_t>(slot));
+}
+
+MenuSession& MenuSessionTable::Begin(uint64_t player_key, const void* owner, int64_t now)
+{
+    uint32_t slot = 0;
+    if (const auto* existing = index_.find(player_key))
+    {
+        slot = *existing;
+    }
+    else
+    {
+        if (free_slots_.empty() && EvictExpired(now) == 0)
+        {
+            // Full of live sessions: reuse the oldest.
+            uint32_t oldest = 0;
+            for (uint32_t i = 1; i < slab_.size(); ++i)
+            {
+                if (slab_[i].touched_at < slab_[oldest].touched_at)
+                    oldest = i;
+            }
+            Free(oldest);
+        }
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        index_.insert_or_assign(player_key, slot);
+    }
+
+    auto& session = slab_[slot];
+    if (session.count != 0)
+        filter_stale_ = true;
+    session.player_key = player_key;
+    session.owner = owner;
+    session.generation = ++last_generation_;
+    session.touched_at = now;
+    session.count = 0;
+    session.filter = &filter_;
+    filter_.MarkOwner(owner);
+    return session;
+}
+
+const MenuEntry* MenuSessionTable::Find(uint64_t player_key, int32_t use_index, int64_t now) const
+{
+    const auto* slot = index_.find(player_key);
+    if (!slot)
+        return nullptr;
+    const auto& session = slab_[*slot];
+    if (Expired(session, now))
+        return nullptr;
+    return session.Find(use_index);
+}
+
+uint32_t MenuSessionTable::Generation(uint64_t player_key, int64_t now) const
+{
+    const auto* slot = index_.find(player_key);
+    if (!slot)
+        return 0;
+    const auto& session = slab_[*slot];
+    return Expired(session, now) ? 0 : session.generation;
+}
+
+void MenuSessionTable::Remove(uint64_t player_key)
+{
+    if (const auto* slot = index_.find(player_key))
+        Free(*slot);
+}
+
+size_t MenuSessionTable::EvictExpired(int64_t now)
+{
+    size_t freed = 0;
+    for (uint32_t slot = 0; slot < slab_.size(); ++slot)
+    {
+        const auto& session = slab_[slot];
+        if (session.player_key != 0 && Expired(session, now))
+        {
+            Free(slot);
+            ++freed;
+        }
+    }
+    return freed;
+}
+
+void MenuSessionTable::CompactFilter()
+{
+    if (!filter_stale_)
+        return;
+    filter_.Clear();
+    for (const auto& session : slab_)
+    {
+        if (session.player_key == 0)
+            continue;
+        filter_.MarkOwner(session.owner);
+        for (uint8_t i = 0; i < session.count; ++i)
+            filter_.MarkUseIndex(session.entries[i].use_index);
+    }
+    filter_stale_ = false;
+}
+
+void MenuSessionTable::Free(uint32_t slot)
+{
+    auto& session = slab_[slot];
+    index_.erase(session.player_key);
+    session.player_key = 0;
+    session.owner = nullptr;
+    session.count = 0;
+    filter_stale_ = true;
+    free_slots_.push_back(slot);
+}
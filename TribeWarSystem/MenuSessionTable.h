@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FlatHashMap.h"
+
+// What a plugin menu entry does when picked.
+enum class MenuAction : uint8_t
+{
+    None,
+    Status,
+    Cancel,
+    AcceptCancel,
+    Declare
+};
+
+struct MenuEntry
+{
+    int32_t use_index = 0;
+    MenuAction action = MenuAction::None;
+    int64_t target_tribe_id = 0; // Declare only
+};
+
+// Cheap "could this be ours?" test run before a MenuSessionTable lookup: a
+// hashed bit per menu owner (the player controller) plus a bitmap of handed-out
+// use indices. Never gives a false negative; a false positive only costs the
+// full lookup. Bits are only ever set here, MenuSessionTable rebuilds it to
+// drop the ones of closed menus.
+class MenuDispatchFilter
+{
+public:
+    static constexpr size_t kOwnerBits = 4096;
+    static constexpr int32_t kUseIndexBits = 1024;
+
+    void MarkOwner(const void* owner)
+    {
+        const size_t bit = OwnerBit(owner);
+        owners_[bit / 64] |= uint64_t(1) << (bit % 64);
+        any_ = true;
+    }
+
+    void MarkUseIndex(int32_t use_index)
+    {
+        if (use_index < 0 || use_index >= kUseIndexBits)
+        {
+            wide_use_index_ = true;
+            return;
+        }
+        use_indices_[use_index / 64] |= uint64_t(1) << (use_index % 64);
+    }
+
+    bool MayMatch(const void* owner, int32_t use_index) const
+    {
+        if (!any_)
+            return false;
+        const size_t bit = OwnerBit(owner);
+        if (!(owners_[bit / 64] & (uint64_t(1) << (bit % 64))))
+            return false;
+        if (use_index < 0 || use_index >= kUseIndexBits)
+            return wide_use_index_;
+        return (use_indices_[use_index / 64] & (uint64_t(1) << (use_index % 64))) != 0;
+    }
+
+    void Clear()
+    {
+        *this = MenuDispatchFilter();
+    }
+
+private:
+    static size_t OwnerBit(const void* owner)
+    {
+        auto x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(owner));
+        x *= 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(x >> 52); // top 12 bits = kOwnerBits
+    }
+
+    bool any_ = false;
+    bool wide_use_index_ = false; // some index fell outside the bitmap
+    uint64_t owners_[kOwnerBits / 64] = {};
+    uint64_t use_indices_[kUseIndexBits / 64] = {};
+};
+
+// The entries of the last plugin menu (MultiUse wheel or radial declare list)
+// a player opened, so the pick can be mapped back to an action.
+struct MenuSession
+{
+    static constexpr size_t kMaxEntries = 72; // Status/Cancel/Accept plus the declare list
+
+    uint64_t player_key = 0;
+    const void* owner = nullptr; // controller the menu was built for
+    uint32_t generation = 0;     // unique per Begin within the table
+    int64_t touched_at = 0;
+    uint8_t count = 0;
+    MenuEntry entries[kMaxEntries];
+    MenuDispatchFilter* filter = nullptr; // the owning table's, set by Begin
+
+    // Returns false when the session is full; the entry is then not offered.
+    bool Add(int32_t use_index, MenuAction action, int64_t target_tribe_id = 0)
+    {
+        if (count >= kMaxEntries)
+            return false;
+        entries[count++] = MenuEntry{ use_index, action, target_tribe_id };
+        if (filter)
+            filter->MarkUseIndex(use_index);
+        return true;
+    }
+
+    const MenuEntry* Find(int32_t use_index) const
+    {
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            if (entries[i].use_index == use_index)
+                return &entries[i];
+        }
+        return nullptr;
+    }
+};
+
+// Fixed-capacity slab of menu sessions keyed by SteamID. A lookup is one hash
+// probe plus a scan of the session's inline entries. Sessions expire `ttl`
+// seconds after their menu was built; when the slab is full the least recently
+// built session is reused, so memory stays bounded however many players pass
+// through.
+//
+// Not thread-safe; the plugin uses it from the game thread only.
+class MenuSessionTable
+{
+public:
+    explicit MenuSessionTable(size_t capacity = 256, int64_t ttl_seconds = 300);
+
+    // Clears the player's session (creating it if needed) for a new menu
+    // shown to `owner`. SteamID 0 is reserved and must not be passed.
+    MenuSession& Begin(uint64_t player_key, const void* owner, int64_t now);
+
+    // False when no live session of `owner` can hold `use_index`; no SteamID
+    // or hash lookup needed. True means "ask Find".
+    bool MayHandle(const void* owner, int32_t use_index) const
+    {
+        return filter_.MayMatch(owner, use_index);
+    }
+
+    // Entry of the player's live session, or nullptr.
+    const MenuEntry* Find(uint64_t player_key, int32_t use_index, int64_t now) const;
+
+    // Generation of the player's live session, 0 when there is none.
+    uint32_t Generation(uint64_t player_key, int64_t now) const;
+
+    void Remove(uint64_t player_key);
+
+    // Frees sessions older than the TTL. Returns how many were freed.
+    size_t EvictExpired(int64_t now);
+
+    // Rebuilds the MayHandle filter from the live sessions if menus were
+    // replaced or freed since the last call.
+    void CompactFilter();
+
+    size_t Size() const
+    {
+        return index_.size();
+    }
+
+    size_t Capacity() const
+    {
+        return slab_.size();
+    }
+
+private:
+    bool Expired(const MenuSession& session, int64_t now) const
+    {
+        return now - session.touched_at >= ttl_seconds_;
+    }
+
+    void Free(uint32_t slot);
+
+    int64_t ttl_seconds_;
+    MenuDispatchFilter filter_;
+    bool filter_stale_ = false;
+    uint32_t last_generation_ = 0;
+    std::vector<MenuSession> slab_;
+    std::vector<uint32_t> free_slots_;
+    FlatHashMap<uint64_t, uint32_t> index_; // SteamID -> slab slot
+};
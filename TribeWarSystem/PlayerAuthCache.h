@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FlatHashMap.h"
+
+// Tribe leader/admin verdicts per player controller, keyed by (controller,
+// tribe ID, generation). The controller is only compared, never dereferenced,
+// so a hit costs no SteamID or player state lookup; the tribe ID is the one the
+// caller already resolved. A verdict is only reused while the player is in the
+// same tribe and the generation has not moved; the plugin starts a new
+// generation every timer tick, so a promotion or demotion (or a controller
+// freed and reallocated at the same address) shows up within a tick while menu
+// hooks and commands in between read a cached bit.
+//
+// Not thread-safe; the plugin uses it from the game thread only.
+class PlayerAuthCache
+{
+public:
+    enum class Verdict : uint8_t
+    {
+        Unknown,
+        Denied,
+        Allowed
+    };
+
+    Verdict Find(const void* controller, int64_t tribe_id) const
+    {
+        const auto* entry = entries_.find(Key(controller));
+        if (!entry || entry->generation != generation_ || entry->tribe_id != tribe_id)
+            return Verdict::Unknown;
+        return entry->allowed ? Verdict::Allowed : Verdict::Denied;
+    }
+
+    void Store(const void* controller, int64_t tribe_id, bool allowed)
+    {
+        entries_.insert_or_assign(Key(controller), Entry{ tribe_id, generation_, allowed });
+    }
+
+    // Invalidates every verdict. Entries stay allocated for the players who
+    // come back next tick; the table is emptied once it outgrows kMaxPlayers
+    // so controllers of departed players do not pile up.
+    void NextGeneration()
+    {
+        ++generation_;
+        if (entries_.size() > kMaxPlayers)
+            entries_.clear();
+    }
+
+    size_t Size() const
+    {
+        return entries_.size();
+    }
+
+private:
+    static constexpr size_t kMaxPlayers = 1024;
+
+    static uint64_t Key(const void* controller)
+    {
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(controller));
+    }
+
+    struct Entry
+    {
+        int64_t tribe_id = 0;
+        uint32_t generation = 0;
+        bool allowed = false;
+    };
+
+    uint32_t generation_ = 1;
+    FlatHashMap<uint64_t, Entry> entries_;
+};
@@ -0,0 +1,202 @@
+#include "PluginStats.h"
+
+#include <atomic>
+#include <cstdio>
+
+namespace
+{
+struct StatCell
+{
+    std::atomic<uint64_t> calls{ 0 };
+    std::atomic<uint64_t> total_ns{ 0 };
+    std::atomic<uint64_t> max_ns{ 0 };
+    std::atomic<uint64_t> overruns{ 0 };
+    std::atomic<uint64_t> deferred{ 0 };
+    std::atomic<uint64_t> failures{ 0 };
+    std::atomic<uint64_t> buckets[kStatBuckets] = {};
+};
+
+// One per recording thread. Only the owner writes, so updates are plain
+// load/store pairs; the atomics just make concurrent reads well-defined.
+struct ThreadStatBlock
+{
+    StatCell cells[kStatCount];
+    ThreadStatBlock* next = nullptr;
+};
+
+// Blocks are pushed once per thread and never unlinked; they live until the
+// module is unloaded.
+class StatBlockList
+{
+public:
+    ~StatBlockList()
+    {
+        auto* block = head_.load();
+        while (block)
+        {
+            auto* next = block->next;
+            delete block;
+            block = next;
+        }
+    }
+
+    ThreadStatBlock* Add()
+    {
+        auto* block = new ThreadStatBlock();
+        block->next = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return block;
+    }
+
+    ThreadStatBlock* Head() const
+    {
+        return head_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<ThreadStatBlock*> head_{ nullptr };
+};
+
+StatBlockList stat_blocks;
+
+ThreadStatBlock& LocalBlock()
+{
+    thread_local ThreadStatBlock* block = stat_blocks.Add();
+    return *block;
+}
+
+int BucketOf(uint64_t ns)
+{
+    int bucket = 0;
+    if (ns >> 32)
+    {
+        bucket += 32;
+        ns >>= 32;
+    }
+    while (ns >>= 1)
+        ++bucket;
+    return bucket < kStatBuckets ? bucket : kStatBuckets - 1;
+}
+
+void Bump(std::atomic<uint64_t>& value, uint64_t delta)
+{
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+}
+
+const char* StatName(Stat stat)
+{
+    switch (stat)
+    {
+    case Stat::DamageHook: return "damage_hook";
+    case Stat::Timer: return "timer";
+    case Stat::TimerNameCache: return "timer.name_cache";
+    case Stat::TimerAbandonedScan: return "timer.abandoned_scan";
+    case Stat::TimerProcessTimers: return "timer.process_timers";
+    case Stat::TimerNotifications: return "timer.notifications";
+    case Stat::TimerSave: return "timer.save";
+    case Stat::TimerNameCacheSave: return "timer.name_cache_save";
+    case Stat::TimerMenuSessions: return "timer.menu_sessions";
+    case Stat::TimerConfigReload: return "timer.config_reload";
+    case Stat::SaveData: return "save_data";
+    case Stat::CmdInfo: return "cmd.info";
+    case Stat::CmdStatus: return "cmd.status";
+    case Stat::CmdWar: return "cmd.war";
+    case Stat::CmdStop: return "cmd.stop";
+    case Stat::CmdAccept: return "cmd.accept";
+    case Stat::Count: break;
+    }
+    return "?";
+}
+
+void RecordStat(Stat stat, uint64_t ns)
+{
+    auto& cell = LocalBlock().cells[static_cast<size_t>(stat)];
+    Bump(cell.calls, 1);
+    Bump(cell.total_ns, ns);
+    Bump(cell.buckets[BucketOf(ns)], 1);
+    if (ns > cell.max_ns.load(std::memory_order_relaxed))
+        cell.max_ns.store(ns, std::memory_order_relaxed);
+}
+
+void RecordStatOverrun(Stat stat)
+{
+    Bump(LocalBlock().cells[static_cast<size_t>(stat)].overruns, 1);
+}
+
+void RecordStatDeferred(Stat stat)
+{
+    Bump(LocalBlock().cells[static_cast<size_t>(stat)].deferred, 1);
+}
+
+void RecordStatFailure(Stat stat)
+{
+    Bump(LocalBlock().cells[static_cast<size_t>(stat)].failures, 1);
+}
+
+uint64_t StatSummary::PercentileNs(double p) const
+{
+    if (calls == 0)
+        return 0;
+    const auto rank = static_cast<uint64_t>(p * static_cast<double>(calls - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < kStatBuckets; ++b)
+    {
+        seen += buckets[b];
+        if (seen >= rank)
+        {
+            const uint64_t upper = uint64_t(1) << (b + 1);
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return max_ns;
+}
+
+std::vector<StatSummary> CollectStats()
+{
+    std::vector<StatSummary> stats(kStatCount);
+    for (size_t i = 0; i < kStatCount; ++i)
+        stats[i].stat = static_cast<Stat>(i);
+
+    for (auto* block = stat_blocks.Head(); block; block = block->next)
+    {
+        for (size_t i = 0; i < kStatCount; ++i)
+        {
+            const auto& cell = block->cells[i];
+            auto& out = stats[i];
+            out.calls += cell.calls.load(std::memory_order_relaxed);
+            out.total_ns += cell.total_ns.load(std::memory_order_relaxed);
+            const auto max_ns = cell.max_ns.load(std::memory_order_relaxed);
+            if (max_ns > out.max_ns)
+                out.max_ns = max_ns;
+            out.overruns += cell.overruns.load(std::memory_order_relaxed);
+            out.deferred += cell.deferred.load(std::memory_order_relaxed);
+            out.failures += cell.failures.load(std::memory_order_relaxed);
+            for (int b = 0; b < kStatBuckets; ++b)
+                out.buckets[b] += cell.buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+    return stats;
+}
+
+std::string FormatStats(const std::vector<StatSummary>& stats)
+{
+    std::string text;
+    char line[192];
+    std::snprintf(line, sizeof(line), "%-24s %12s %10s %10s %10s %10s %9s %9s %9s\n", "stat", "calls", "mean_us", "p50_us", "p99_us",
+                  "max_us", "overruns", "deferred", "failures");
+    text += line;
+    for (const auto& s : stats)
+    {
+        const double mean_us = s.calls ? static_cast<double>(s.total_ns) / static_cast<double>(s.calls) / 1000.0 : 0.0;
+        std::snprintf(line, sizeof(line), "%-24s %12llu %10.1f %10.1f %10.1f %10.1f %9llu %9llu %9llu\n", StatName(s.stat),
+                      static_cast<unsigned long long>(s.calls), mean_us, static_cast<double>(s.PercentileNs(0.50)) / 1000.0,
+                      static_cast<double>(s.PercentileNs(0.99)) / 1000.0, static_cast<double>(s.max_ns) / 1000.0,
+                      static_cast<unsigned long long>(s.overruns), static_cast<unsigned long long>(s.deferred),
+                      static_cast<unsigned long long>(s.failures));
+        text += line;
+    }
+    return text;
+}
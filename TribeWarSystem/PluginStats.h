@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Trace.h"
+
+// Call counts and latency histograms for the plugin's hooks, timer stages and
+// commands.
+//
+// Each thread records into its own block, so there are no shared writes and no
+// locks on the hot path. Readers sum all blocks with relaxed loads; a snapshot
+// taken while threads are recording may be off by the calls in flight.
+enum class Stat : uint8_t
+{
+    DamageHook,
+    Timer,
+    TimerNameCache,
+    TimerAbandonedScan,
+    TimerProcessTimers,
+    TimerNotifications,
+    TimerSave,
+    TimerNameCacheSave,
+    TimerMenuSessions,
+    TimerConfigReload,
+    SaveData,
+    CmdInfo,
+    CmdStatus,
+    CmdWar,
+    CmdStop,
+    CmdAccept,
+    Count
+};
+
+constexpr size_t kStatCount = static_cast<size_t>(Stat::Count);
+constexpr int kStatBuckets = 40; // log2(ns): bucket b holds [2^b, 2^(b+1)) ns
+
+const char* StatName(Stat stat);
+
+void RecordStat(Stat stat, uint64_t ns);
+// Timer stages (StageScheduler): ran past the budget / left work for the next
+// tick / threw and was cut short.
+void RecordStatOverrun(Stat stat);
+void RecordStatDeferred(Stat stat);
+void RecordStatFailure(Stat stat);
+
+// Times the enclosing scope; also a trace event while a capture runs.
+class StatScope
+{
+public:
+    explicit StatScope(Stat stat)
+        : stat_(stat), start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~StatScope()
+    {
+        const auto end = std::chrono::steady_clock::now();
+        RecordStat(stat_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count()));
+        if (TraceEnabled())
+            TraceComplete(StatName(stat_), "plugin", start_, end);
+    }
+
+    StatScope(const StatScope&) = delete;
+    StatScope& operator=(const StatScope&) = delete;
+
+private:
+    Stat stat_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+struct StatSummary
+{
+    Stat stat = Stat::DamageHook;
+    uint64_t calls = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t overruns = 0;
+    uint64_t deferred = 0;
+    uint64_t failures = 0;
+    uint64_t buckets[kStatBuckets] = {};
+
+    // Upper edge of the bucket holding the p-th call, capped by max_ns.
+    uint64_t PercentileNs(double p) const;
+};
+
+// All stats, summed over every thread that recorded anything, in Stat order.
+std::vector<StatSummary> CollectStats();
+
+// Fixed-width table, one line per stat.
+std::string FormatStats(const std::vector<StatSummary>& stats);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "GameWorld.h"
+
+// In-memory IGameWorld for benchmarks and the war simulator. Everything is
+// plain data that the caller sets up directly. Pair it with a ManualClock.
+class SimWorld final : public IGameWorld
+{
+public:
+    bool ready = true;
+    std::vector<TribeMembers> tribes;            // tribe table rows
+    std::unordered_set<int64_t> online;          // tribes with a connected member
+    std::unordered_set<uint64_t> alliances;      // AllianceKey pairs
+    std::unordered_map<const void*, std::string> class_paths;
+
+    uint64_t alliance_queries = 0;
+
+    static uint64_t AllianceKey(int64_t a, int64_t b)
+    {
+        if (a > b)
+            std::swap(a, b);
+        return (static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32) | static_cast<uint32_t>(b);
+    }
+
+    void Ally(int64_t a, int64_t b)
+    {
+        alliances.insert(AllianceKey(a, b));
+    }
+
+    void Unally(int64_t a, int64_t b)
+    {
+        alliances.erase(AllianceKey(a, b));
+    }
+
+    bool IsReady() override
+    {
+        return ready;
+    }
+
+    bool AreTribesAllied(int64_t tribe_id, int64_t other_id) override
+    {
+        ++alliance_queries;
+        return alliances.count(AllianceKey(tribe_id, other_id)) != 0;
+    }
+
+    bool IsTribeOnline(int64_t tribe_id) override
+    {
+        return online.count(tribe_id) != 0;
+    }
+
+    int32_t GetTribeCount() override
+    {
+        return static_cast<int32_t>(tribes.size());
+    }
+
+    void ReadTribeMembers(int32_t begin, int32_t end, std::vector<TribeMembers>& out) override
+    {
+        for (int32_t i = begin; i < end && i < GetTribeCount(); ++i)
+            out.push_back(tribes[static_cast<size_t>(i)]);
+    }
+
+    bool TryGetClassPath(const void* structure_class, std::string& out_path) override
+    {
+        const auto it = class_paths.find(structure_class);
+        if (it == class_paths.end())
+            return false;
+        out_path = it->second;
+        return true;
+    }
+};
@@ -0,0 +1,33 @@
+#include "StageScheduler.h"
+
+#include <algorithm>
+
+void StageScheduler::RunTick(int32_t budget_us)
+{
+    const auto budget = std::chrono::microseconds((std::max)(1, budget_us));
+    for (auto& stage : stages_)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        bool done = true;
+        try
+        {
+            done = stage.run(StageDeadline(start + budget));
+        }
+        catch (...)
+        {
+            // A failing stage must not starve the ones after it, but it shows
+            // up in TribeWar.Stats.
+            RecordStatFailure(stage.stat);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const auto elapsed = end - start;
+        if (TraceEnabled())
+            TraceComplete(StatName(stage.stat), "timer", start, end);
+
+        RecordStat(stage.stat, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        if (elapsed > budget)
+            RecordStatOverrun(stage.stat);
+        if (!done)
+            RecordStatDeferred(stage.stat);
+    }
+}
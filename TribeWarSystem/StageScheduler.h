@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "PluginStats.h"
+
+// End of a stage's time slice. Stages check it between units of work.
+class StageDeadline
+{
+public:
+    explicit StageDeadline(std::chrono::steady_clock::time_point end)
+        : end_(end)
+    {
+    }
+
+    // For callers outside the timer that need the whole job done now.
+    static StageDeadline Unbounded()
+    {
+        return StageDeadline((std::chrono::steady_clock::time_point::max)());
+    }
+
+    bool Expired() const
+    {
+        return std::chrono::steady_clock::now() >= end_;
+    }
+
+private:
+    std::chrono::steady_clock::time_point end_;
+};
+
+// Cooperative scheduler for the timer tick. Stages run in order, each with the
+// same microsecond budget. A stage returns false when it stopped at the
+// deadline with work left; it keeps its own cursor and is called again on the
+// next tick. Stages that cannot be split just ignore the deadline.
+//
+// Per stage, PluginStats gets the run time, an overrun whenever the budget was
+// exceeded, a deferral whenever work was carried over, and a failure whenever
+// the stage threw (the remaining stages still run).
+class StageScheduler
+{
+public:
+    using StageFn = std::function<bool(const StageDeadline&)>;
+
+    void Add(Stat stat, StageFn run)
+    {
+        stages_.push_back(Stage{ stat, std::move(run) });
+    }
+
+    void RunTick(int32_t budget_us);
+
+private:
+    struct Stage
+    {
+        Stat stat;
+        StageFn run;
+    };
+
+    std::vector<Stage> stages_;
+};
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "Trace.h"
+
+#ifdef TRIBEWAR_LOCK_PROFILE
+#include "LockProfiler.h"
+#endif
+
+// Benchmarks build with TRIBEWAR_LOCK_STATS to count mutex acquisitions per
+// thread. Off in the plugin build, where it compiles to nothing.
+#ifdef TRIBEWAR_LOCK_STATS
+inline thread_local uint64_t lock_acquisitions = 0;
+#define TRIBEWAR_COUNT_LOCK() (++lock_acquisitions)
+#else
+#define TRIBEWAR_COUNT_LOCK() ((void)0)
+#endif
+
+#ifdef _WIN32
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+
+// std::mutex has been observed to crash in this environment (inside MSVCP140.dll).
+// Use a WinAPI SRWLOCK-based mutex to avoid STL runtime mutex internals.
+class NativeLock
+{
+public:
+    NativeLock() noexcept
+    {
+        InitializeSRWLock(&lock_);
+    }
+
+    bool TryLock() noexcept
+    {
+        return TryAcquireSRWLockExclusive(&lock_) != 0;
+    }
+
+    void Lock() noexcept
+    {
+        AcquireSRWLockExclusive(&lock_);
+    }
+
+    void Unlock() noexcept
+    {
+        ReleaseSRWLockExclusive(&lock_);
+    }
+
+private:
+    friend class NativeCondition;
+    SRWLOCK lock_{};
+};
+
+// Condition variable paired with a NativeLock (CONDITION_VARIABLE on the SRWLOCK).
+class NativeCondition
+{
+public:
+    NativeCondition() noexcept
+    {
+        InitializeConditionVariable(&condition_);
+    }
+
+    // `lock` must be held; it is released while waiting. May wake spuriously.
+    void Wait(NativeLock& lock) noexcept
+    {
+        SleepConditionVariableSRW(&condition_, &lock.lock_, INFINITE, 0);
+    }
+
+    // Wait, but gives up after `milliseconds`.
+    void WaitFor(NativeLock& lock, uint32_t milliseconds) noexcept
+    {
+        SleepConditionVariableSRW(&condition_, &lock.lock_, milliseconds, 0);
+    }
+
+    void NotifyAll() noexcept
+    {
+        WakeAllConditionVariable(&condition_);
+    }
+
+private:
+    CONDITION_VARIABLE condition_{};
+};
+
+#else
+
+// Headless builds (benchmarks, CMake) have no SRWLOCK; the MSVC runtime issue
+// above does not apply there.
+class NativeLock
+{
+public:
+    bool TryLock()
+    {
+        return lock_.try_lock();
+    }
+
+    void Lock()
+    {
+        lock_.lock();
+    }
+
+    void Unlock()
+    {
+        lock_.unlock();
+    }
+
+private:
+    friend class NativeCondition;
+    std::mutex lock_;
+};
+
+class NativeCondition
+{
+public:
+    void Wait(NativeLock& lock)
+    {
+        std::unique_lock<std::mutex> held(lock.lock_, std::adopt_lock);
+        condition_.wait(held);
+        held.release();
+    }
+
+    void WaitFor(NativeLock& lock, uint32_t milliseconds)
+    {
+        std::unique_lock<std::mutex> held(lock.lock_, std::adopt_lock);
+        condition_.wait_for(held, std::chrono::milliseconds(milliseconds));
+        held.release();
+    }
+
+    void NotifyAll()
+    {
+        condition_.notify_all();
+    }
+
+private:
+    std::condition_variable condition_;
+};
+
+#endif
+
+// `name` labels contended acquisitions in traces (see Trace.h) and, with
+// TRIBEWAR_LOCK_PROFILE, the mutex in the lock profile (see LockProfiler.h).
+// `function`/`line` are the caller's, passed by LockGuard; std::lock_guard
+// works too but leaves the call site unknown.
+struct WinMutex
+{
+    explicit WinMutex(const char* name = "mutex") noexcept
+        : name_(name)
+#ifdef TRIBEWAR_LOCK_PROFILE
+        , profile_(name)
+#endif
+    {
+    }
+
+    WinMutex(const WinMutex&) = delete;
+    WinMutex& operator=(const WinMutex&) = delete;
+
+#ifdef TRIBEWAR_LOCK_PROFILE
+    void lock(const char* function = nullptr, int line = 0) noexcept
+    {
+        TRIBEWAR_COUNT_LOCK();
+        if (lock_.TryLock())
+        {
+            held_since_ = std::chrono::steady_clock::now();
+            held_site_ = profile_.Acquired(function, line, false, 0);
+            return;
+        }
+        const auto wait_start = std::chrono::steady_clock::now();
+        {
+            TraceScope wait(name_, "lock_wait");
+            lock_.Lock();
+        }
+        held_since_ = std::chrono::steady_clock::now();
+        held_site_ = profile_.Acquired(function, line, true, Nanoseconds(wait_start, held_since_));
+    }
+
+    void unlock() noexcept
+    {
+        profile_.Released(held_site_, Nanoseconds(held_since_, std::chrono::steady_clock::now()));
+        lock_.Unlock();
+    }
+#else
+    void lock(const char* = nullptr, int = 0) noexcept
+    {
+        TRIBEWAR_COUNT_LOCK();
+        if (lock_.TryLock())
+            return;
+        TraceScope wait(name_, "lock_wait");
+        lock_.Lock();
+    }
+
+    void unlock() noexcept
+    {
+        lock_.Unlock();
+    }
+#endif
+
+private:
+    const char* name_;
+    NativeLock lock_;
+#ifdef TRIBEWAR_LOCK_PROFILE
+    static uint64_t Nanoseconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
+    LockProfile profile_;
+    // Written by the holder only.
+    std::chrono::steady_clock::time_point held_since_;
+    LockSite* held_site_ = nullptr;
+#endif
+};
+
+// Scoped lock that reports its call site to the lock profile. Without
+// TRIBEWAR_LOCK_PROFILE it is std::lock_guard.
+#ifdef TRIBEWAR_LOCK_PROFILE
+template <typename Mutex>
+class LockGuard
+{
+public:
+    explicit LockGuard(Mutex& mutex, const char* function = __builtin_FUNCTION(), int line = __builtin_LINE())
+        : mutex_(mutex)
+    {
+        mutex_.lock(function, line);
+    }
+
+    ~LockGuard()
+    {
+        mutex_.unlock();
+    }
+
+    LockGuard(const LockGuard&) = delete;
+    LockGuard& operator=(const LockGuard&) = delete;
+
+private:
+    Mutex& mutex_;
+};
+#else
+template <typename Mutex>
+using LockGuard = std::lock_guard<Mutex>;
+#endif
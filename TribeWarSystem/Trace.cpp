@@ -0,0 +1,234 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+std::atomic<bool> trace_enabled{ false };
+
+namespace
+{
+struct TraceEvent
+{
+    const char* name = nullptr;
+    const char* category = nullptr;
+    int64_t start_ns = 0; // since the capture started
+    int64_t duration_ns = 0;
+    char phase = 'X';
+    char text[111] = {}; // instant events only, truncated
+};
+
+// One per tracing thread, only written by its owner. `written` is published
+// after each event so a reader sees whole events. WriteTrace reads the ring
+// while no capture runs; StartTrace waits for it, so the owner cannot reset
+// `written` under it.
+struct TraceBlock
+{
+    uint32_t thread_index = 0;
+    std::atomic<uint32_t> generation{ 0 };
+    std::vector<TraceEvent> ring;
+    std::atomic<uint64_t> written{ 0 };
+    TraceBlock* next = nullptr;
+};
+
+std::atomic<TraceBlock*> trace_blocks{ nullptr };
+std::atomic<uint32_t> trace_generation{ 0 };
+std::atomic<int64_t> trace_epoch_ns{ 0 };
+std::atomic<size_t> trace_capacity{ 1 << 14 };
+std::atomic<uint32_t> trace_thread_count{ 0 };
+std::atomic<bool> trace_write_pending{ false }; // StopTrace .. WriteTrace
+
+// Blocks live until the module is unloaded.
+struct TraceBlockCleanup
+{
+    ~TraceBlockCleanup()
+    {
+        auto* block = trace_blocks.load();
+        while (block)
+        {
+            auto* next = block->next;
+            delete block;
+            block = next;
+        }
+    }
+} trace_block_cleanup;
+
+int64_t SteadyNs(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+TraceBlock& LocalTraceBlock()
+{
+    thread_local TraceBlock* block = []() {
+        auto* created = new TraceBlock();
+        created->thread_index = trace_thread_count.fetch_add(1) + 1;
+        created->ring.resize((std::max)(size_t(64), trace_capacity.load()));
+        created->next = trace_blocks.load(std::memory_order_relaxed);
+        while (!trace_blocks.compare_exchange_weak(created->next, created, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return created;
+    }();
+    return *block;
+}
+
+TraceEvent* BeginEvent()
+{
+    auto& block = LocalTraceBlock();
+    const auto generation = trace_generation.load(std::memory_order_acquire);
+    if (block.generation.load(std::memory_order_relaxed) != generation)
+    {
+        block.generation.store(generation, std::memory_order_relaxed);
+        block.written.store(0, std::memory_order_release);
+    }
+    const auto index = block.written.load(std::memory_order_relaxed);
+    return &block.ring[index % block.ring.size()];
+}
+
+void CommitEvent()
+{
+    auto& block = LocalTraceBlock();
+    block.written.store(block.written.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AppendJsonString(std::string& out, const char* text)
+{
+    out += '"';
+    for (const char* p = text; p && *p; ++p)
+    {
+        const auto c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else
+            out += static_cast<char>(c);
+    }
+    out += '"';
+}
+}
+
+bool StartTrace(size_t events_per_thread)
+{
+    if (trace_write_pending.load(std::memory_order_acquire))
+        return false;
+    trace_capacity.store(events_per_thread);
+    trace_epoch_ns.store(SteadyNs(std::chrono::steady_clock::now()));
+    trace_generation.fetch_add(1, std::memory_order_release);
+    trace_enabled.store(true);
+    return true;
+}
+
+uint32_t StopTrace()
+{
+    trace_write_pending.store(true, std::memory_order_release);
+    trace_enabled.store(false);
+    return trace_generation.load(std::memory_order_acquire);
+}
+
+void TraceComplete(const char* name, const char* category, std::chrono::steady_clock::time_point start,
+                   std::chrono::steady_clock::time_point end)
+{
+    if (!TraceEnabled())
+        return;
+    auto* event = BeginEvent();
+    event->name = name;
+    event->category = category;
+    event->start_ns = SteadyNs(start) - trace_epoch_ns.load(std::memory_order_relaxed);
+    event->duration_ns = SteadyNs(end) - SteadyNs(start);
+    event->phase = 'X';
+    event->text[0] = '\0';
+    CommitEvent();
+}
+
+void TraceInstant(const char* category, const std::string& text)
+{
+    if (!TraceEnabled())
+        return;
+    auto* event = BeginEvent();
+    event->name = category;
+    event->category = category;
+    event->start_ns = SteadyNs(std::chrono::steady_clock::now()) - trace_epoch_ns.load(std::memory_order_relaxed);
+    event->duration_ns = 0;
+    event->phase = 'i';
+    auto length = (std::min)(text.size(), sizeof(event->text) - 1);
+    while (length < text.size() && length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80)
+        --length; // do not cut a UTF-8 sequence
+    std::memcpy(event->text, text.data(), length);
+    event->text[length] = '\0';
+    CommitEvent();
+}
+
+bool WriteTrace(const std::string& path, uint32_t generation)
+{
+    struct PendingReset
+    {
+        ~PendingReset()
+        {
+            trace_write_pending.store(false, std::memory_order_release);
+        }
+    } pending_reset;
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char number[96];
+    for (auto* block = trace_blocks.load(std::memory_order_acquire); block; block = block->next)
+    {
+        if (block->generation.load(std::memory_order_acquire) != generation)
+            continue;
+        const auto written = block->written.load(std::memory_order_acquire);
+        const auto capacity = static_cast<uint64_t>(block->ring.size());
+        // When wrapped, skip a few of the oldest slots: a writer that was mid-event
+        // when the capture stopped may still be filling one of them.
+        const uint64_t begin = written > capacity ? written - capacity + 8 : 0;
+        for (auto i = begin; i < written; ++i)
+        {
+            const auto& event = block->ring[i % capacity];
+            if (!first)
+                out += ',';
+            first = false;
+            out += "{\"name\":";
+            AppendJsonString(out, event.name);
+            out += ",\"cat\":";
+            AppendJsonString(out, event.category);
+            std::snprintf(number, sizeof(number), ",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", event.phase,
+                          block->thread_index, static_cast<double>(event.start_ns) / 1000.0);
+            out += number;
+            if (event.phase == 'X')
+            {
+                std::snprintf(number, sizeof(number), ",\"dur\":%.3f}", static_cast<double>(event.duration_ns) / 1000.0);
+                out += number;
+            }
+            else
+            {
+                out += ",\"s\":\"t\",\"args\":{\"text\":";
+                AppendJsonString(out, event.text);
+                out += "}}";
+            }
+        }
+    }
+    out += "]}";
+
+    try
+    {
+        std::ofstream file(path, std::ios::trunc | std::ios::binary);
+        if (!file.is_open())
+            return false;
+        file << out;
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
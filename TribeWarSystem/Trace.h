@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opt-in Chrome trace capture (chrome://tracing, ui.perfetto.dev).
+//
+// While a capture runs, every thread records into its own ring buffer:
+// complete events for hooks, timer stages, commands, lock waits and file I/O,
+// and instant events for log lines. Nothing is shared between writers and the
+// disabled path is a single relaxed load. When the ring wraps, the oldest
+// events of that thread are dropped.
+//
+// Event names and categories must be string literals (or otherwise outlive the
+// capture); only instant-event text is copied.
+
+extern std::atomic<bool> trace_enabled;
+
+inline bool TraceEnabled()
+{
+    return trace_enabled.load(std::memory_order_relaxed);
+}
+
+// Starts a new capture; earlier events are discarded. `events_per_thread` only
+// applies to threads that have not traced before. Returns false, and starts
+// nothing, while a stopped capture has not been written yet: the new capture
+// would reuse the rings WriteTrace is reading.
+bool StartTrace(size_t events_per_thread);
+
+// Ends the capture and returns its generation for WriteTrace, which must be
+// called once afterwards (it also lets StartTrace run again).
+uint32_t StopTrace();
+
+// Writes capture `generation` as Chrome trace JSON. Call after StopTrace(),
+// from any thread (the plugin uses the I/O worker).
+bool WriteTrace(const std::string& path, uint32_t generation);
+
+void TraceComplete(const char* name, const char* category, std::chrono::steady_clock::time_point start,
+                   std::chrono::steady_clock::time_point end);
+void TraceInstant(const char* category, const std::string& text);
+
+class TraceScope
+{
+public:
+    TraceScope(const char* name, const char* category)
+        : name_(name), category_(category), active_(TraceEnabled())
+    {
+        if (active_)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    ~TraceScope()
+    {
+        if (active_)
+            TraceComplete(name_, category_, start_, std::chrono::steady_clock::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    bool active_;
+    std::chrono::steady_clock::time_point start_;
+};
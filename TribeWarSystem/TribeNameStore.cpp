@@ -0,0 +1,155 @@
+#include "TribeNameStore.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "Trace.h"
+#include "json.hpp"
+
+namespace
+{
+// Rewrite the snapshot once the delta log reaches this size.
+constexpr uint64_t kCompactLogBytes = 1024 * 1024;
+
+int64_t CanonicalId(int64_t raw_id)
+{
+    return static_cast<int64_t>(static_cast<uint32_t>(static_cast<int32_t>(raw_id)));
+}
+}
+
+void TribeNameStore::Open(std::string snapshot_path, std::string log_path)
+{
+    snapshot_path_ = std::move(snapshot_path);
+    log_path_ = std::move(log_path);
+    names_.clear();
+    log_bytes_ = 0;
+}
+
+std::unordered_map<int64_t, std::string> TribeNameStore::Load()
+{
+    TraceScope trace("TribeNameStore::Load", "io");
+    names_.clear();
+    log_bytes_ = 0;
+
+    try
+    {
+        std::ifstream file(snapshot_path_, std::ios::in | std::ios::binary);
+        if (file.is_open())
+        {
+            const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            const auto json = nlohmann::json::parse(content, nullptr, false);
+            if (!json.is_discarded() && json.find("names") != json.end() && json["names"].is_object())
+            {
+                for (auto it = json["names"].begin(); it != json["names"].end(); ++it)
+                {
+                    if (!it.value().is_string())
+                        continue;
+                    names_[CanonicalId(std::stoll(it.key()))] = it.value().get<std::string>();
+                }
+            }
+        }
+    }
+    catch (...)
+    {
+        // ignore, replay the log on whatever was read
+    }
+
+    try
+    {
+        std::ifstream log(log_path_, std::ios::in | std::ios::binary);
+        std::string line;
+        while (log.is_open() && std::getline(log, line))
+        {
+            log_bytes_ += line.size() + 1;
+            const auto item = nlohmann::json::parse(line, nullptr, false);
+            if (item.is_discarded() || !item.is_object())
+                continue; // torn write at the tail
+            const int64_t id = CanonicalId(item.value("id", static_cast<int64_t>(0)));
+            const std::string name = item.value("name", std::string());
+            if (id != 0 && !name.empty())
+                names_[id] = name;
+        }
+    }
+    catch (...)
+    {
+        // ignore
+    }
+
+    return names_;
+}
+
+void TribeNameStore::Append(const std::vector<TribeNameDelta>& deltas)
+{
+    if (deltas.empty())
+        return;
+    TraceScope trace("TribeNameStore::Append", "io");
+
+    try
+    {
+        std::string out;
+        for (const auto& delta : deltas)
+        {
+            names_[delta.tribe_id] = delta.name;
+
+            nlohmann::json item;
+            item["id"] = delta.tribe_id;
+            item["name"] = delta.name;
+            out += item.dump();
+            out += '\n';
+        }
+
+        std::filesystem::create_directories(std::filesystem::path(log_path_).parent_path());
+        std::ofstream log(log_path_, std::ios::app | std::ios::binary);
+        if (!log.is_open())
+            return;
+        log << out;
+        log_bytes_ += out.size();
+    }
+    catch (...)
+    {
+        // ignore
+    }
+
+    if (log_bytes_ >= kCompactLogBytes)
+        Compact();
+}
+
+void TribeNameStore::Compact()
+{
+    TraceScope trace("TribeNameStore::Compact", "io");
+    try
+    {
+        nlohmann::json names = nlohmann::json::object();
+        for (const auto& it : names_)
+            names[std::to_string(it.first)] = it.second;
+
+        nlohmann::json json;
+        json["names"] = std::move(names);
+
+        std::filesystem::create_directories(std::filesystem::path(snapshot_path_).parent_path());
+
+        // Write to a temp file first so a crash mid-write never loses the snapshot.
+        const std::string tmp_path = snapshot_path_ + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::trunc | std::ios::binary);
+            if (!file.is_open())
+                return;
+            file << json.dump(2);
+            if (!file)
+                return;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, snapshot_path_, ec);
+        if (ec)
+            return;
+
+        // Snapshot now contains every delta: the log can start over.
+        std::ofstream log(log_path_, std::ios::trunc | std::ios::binary);
+        log_bytes_ = 0;
+    }
+    catch (...)
+    {
+        // ignore
+    }
+}
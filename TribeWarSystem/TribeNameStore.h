@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TribeNameDelta
+{
+    int64_t tribe_id = 0;
+    std::string name; // UTF-8
+};
+
+// On-disk tribe name cache: a snapshot (tribe_names.json) plus an append-only
+// delta log (tribe_names.log, one JSON object per line). Renames only append
+// to the log; the snapshot is rewritten when the log grows past a threshold
+// or on Compact() (plugin unload).
+//
+// Not thread-safe. After Load() the store is owned by the background worker.
+class TribeNameStore
+{
+public:
+    void Open(std::string snapshot_path, std::string log_path);
+
+    // Reads the snapshot and replays the delta log on top of it.
+    std::unordered_map<int64_t, std::string> Load();
+
+    void Append(const std::vector<TribeNameDelta>& deltas);
+    void Compact();
+
+private:
+    std::string snapshot_path_;
+    std::string log_path_;
+    std::unordered_map<int64_t, std::string> names_;
+    uint64_t log_bytes_ = 0;
+};
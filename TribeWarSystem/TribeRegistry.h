@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "FlatHashMap.h"
+
+using TribeIndex = uint32_t;
+constexpr TribeIndex kNoTribeIndex = (std::numeric_limits<TribeIndex>::max)();
+constexpr uint32_t kNoNameHandle = (std::numeric_limits<uint32_t>::max)();
+
+// Dense per-tribe state. Every canonical tribe ID that the plugin has seen gets a
+// stable index (never reused), and per-tribe data lives in parallel vectors so
+// hot lookups are one hash probe followed by array indexing.
+//
+// Not thread-safe; callers guard it with data_mutex.
+struct TribeRegistry
+{
+    // Columns, all indexed by TribeIndex.
+    std::vector<int64_t> tribe_id;
+    std::vector<int64_t> war_id;            // war this tribe is a direct participant of, 0 = none
+    std::vector<int64_t> cooldown_end;      // this tribe's cooldown deadline, 0 = none
+    std::vector<int64_t> abandoned_until;   // 0 = not abandoned
+    std::vector<int32_t> member_count;      // last observed member count, -1 = unknown
+    std::vector<uint32_t> seen_sweep;       // abandoned scan sweep that last saw this tribe
+    std::vector<uint32_t> name_handle;      // index into the tribe name table
+
+    TribeIndex Find(int64_t id) const
+    {
+        const auto* index = index_.find(id);
+        return index ? *index : kNoTribeIndex;
+    }
+
+    TribeIndex Intern(int64_t id)
+    {
+        auto inserted = index_.try_emplace(id);
+        if (!inserted.second)
+            return inserted.first->second;
+
+        const auto index = static_cast<TribeIndex>(tribe_id.size());
+        inserted.first->second = index;
+        tribe_id.push_back(id);
+        war_id.push_back(0);
+        cooldown_end.push_back(0);
+        abandoned_until.push_back(0);
+        member_count.push_back(-1);
+        seen_sweep.push_back(0);
+        name_handle.push_back(kNoNameHandle);
+        return index;
+    }
+
+    size_t Size() const
+    {
+        return tribe_id.size();
+    }
+
+    void Clear()
+    {
+        index_.clear();
+        tribe_id.clear();
+        war_id.clear();
+        cooldown_end.clear();
+        abandoned_until.clear();
+        member_count.clear();
+        seen_sweep.clear();
+        name_handle.clear();
+    }
+
+private:
+    FlatHashMap<int64_t, TribeIndex> index_;
+};
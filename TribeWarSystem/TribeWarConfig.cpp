@@ -0,0 +1,216 @@
+#include "TribeWarConfig.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+
+#include "Trace.h"
+#include "json.hpp"
+
+std::string ToLowerAscii(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string NormalizeBlueprintPath(const std::string& path)
+{
+    std::string lower = ToLowerAscii(path);
+    const std::string prefix = "blueprint'";
+    if (lower.rfind(prefix, 0) == 0)
+        lower = lower.substr(prefix.size());
+    if (!lower.empty() && lower.back() == '\'')
+        lower.pop_back();
+    return lower;
+}
+
+StructureExclusionMatcher::StructureExclusionMatcher(std::vector<std::string> patterns)
+    : patterns_(std::move(patterns))
+{
+}
+
+size_t StructureExclusionMatcher::SlotOf(const void* structure_class)
+{
+    auto x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(structure_class));
+    x *= 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(x >> 56); // top 8 bits = kMemoSlots
+}
+
+StructureExclusionMatcher::Memo StructureExclusionMatcher::Lookup(const void* structure_class) const
+{
+    const auto handle = reinterpret_cast<uintptr_t>(structure_class);
+    const auto value = memo_[SlotOf(structure_class)].load(std::memory_order_relaxed);
+    if (value == 0 || (value & ~uintptr_t(1)) != handle)
+        return Memo::Unknown;
+    return (value & 1) ? Memo::Excluded : Memo::Included;
+}
+
+void StructureExclusionMatcher::Remember(const void* structure_class, bool excluded) const
+{
+    const auto handle = reinterpret_cast<uintptr_t>(structure_class);
+    if (handle == 0 || (handle & 1))
+        return;
+    memo_[SlotOf(structure_class)].store(handle | (excluded ? 1 : 0), std::memory_order_relaxed);
+}
+
+bool StructureExclusionMatcher::MatchesPath(const std::string& normalized_path) const
+{
+    for (const auto& pattern : patterns_)
+    {
+        if (normalized_path.find(pattern) != std::string::npos)
+            return true;
+    }
+    return false;
+}
+
+void SaveConfigFile(const std::string& path, const Config& config)
+{
+    TraceScope trace("SaveConfigFile", "io");
+    std::ofstream file(path, std::ios::trunc);
+    nlohmann::json json;
+    json["war_delay_seconds"] = config.war_delay_seconds;
+    json["cooldown_seconds"] = config.cooldown_seconds;
+    json["structure_damage_multiplier"] = config.structure_damage_multiplier;
+    json["excluded_structure_blueprints"] = config.excluded_structure_blueprints;
+    json["enable_abandoned_structure_window"] = config.enable_abandoned_structure_window;
+    json["abandoned_structure_window_seconds"] = config.abandoned_structure_window_seconds;
+    json["abandoned_structure_damage_multiplier"] = config.abandoned_structure_damage_multiplier;
+    json["abandoned_scan_batch"] = config.abandoned_scan_batch;
+
+    json["enable_multiuse_menu"] = config.enable_multiuse_menu;
+    json["multiuse_require_owned_structure"] = config.multiuse_require_owned_structure;
+    json["multiuse_require_leader"] = config.multiuse_require_leader;
+    json["multiuse_max_targets"] = config.multiuse_max_targets;
+    json["enable_tribe_radial_menu"] = config.enable_tribe_radial_menu;
+
+    json["debug_multiuse_log"] = config.debug_multiuse_log;
+    json["log_max_bytes"] = config.log_max_bytes;
+    json["log_keep_files"] = config.log_keep_files;
+    json["stats_file_interval_seconds"] = config.stats_file_interval_seconds;
+    json["trace_events_per_thread"] = config.trace_events_per_thread;
+    json["timer_stage_budget_us"] = config.timer_stage_budget_us;
+    json["config_poll_seconds"] = config.config_poll_seconds;
+
+    json["self_test"] = config.self_test;
+    json["self_test_tribe_a"] = config.self_test_tribe_a;
+    json["self_test_tribe_b"] = config.self_test_tribe_b;
+    json["self_test_active_seconds"] = config.self_test_active_seconds;
+    json["self_test_simulate"] = config.self_test_simulate;
+    json["self_test_sim_seed"] = config.self_test_sim_seed;
+    json["self_test_sim_tribes"] = config.self_test_sim_tribes;
+    json["self_test_sim_wars"] = config.self_test_sim_wars;
+    json["self_test_sim_ticks"] = config.self_test_sim_ticks;
+
+    file << json.dump(2);
+}
+
+bool LoadConfigFile(const std::string& path, Config& config, std::string* error)
+{
+    TraceScope trace("LoadConfigFile", "io");
+    try
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+            return false;
+
+        nlohmann::json json;
+        file >> json;
+        config.war_delay_seconds = json.value("war_delay_seconds", config.war_delay_seconds);
+        config.cooldown_seconds = json.value("cooldown_seconds", config.cooldown_seconds);
+        config.structure_damage_multiplier = json.value("structure_damage_multiplier", config.structure_damage_multiplier);
+        config.excluded_structure_blueprints.clear();
+        if (json.find("excluded_structure_blueprints") != json.end() && json["excluded_structure_blueprints"].is_array())
+        {
+            for (const auto& item : json["excluded_structure_blueprints"])
+            {
+                if (!item.is_string())
+                    continue;
+                const auto normalized = NormalizeBlueprintPath(item.get<std::string>());
+                if (!normalized.empty())
+                    config.excluded_structure_blueprints.push_back(normalized);
+            }
+        }
+        config.enable_abandoned_structure_window = json.value("enable_abandoned_structure_window", config.enable_abandoned_structure_window);
+        config.abandoned_structure_window_seconds = json.value("abandoned_structure_window_seconds", config.abandoned_structure_window_seconds);
+        config.abandoned_structure_damage_multiplier = json.value("abandoned_structure_damage_multiplier", config.abandoned_structure_damage_multiplier);
+        config.abandoned_scan_batch = json.value("abandoned_scan_batch", config.abandoned_scan_batch);
+
+        config.enable_multiuse_menu = json.value("enable_multiuse_menu", config.enable_multiuse_menu);
+        config.multiuse_require_owned_structure = json.value("multiuse_require_owned_structure", config.multiuse_require_owned_structure);
+        config.multiuse_require_leader = json.value("multiuse_require_leader", config.multiuse_require_leader);
+        config.multiuse_max_targets = json.value("multiuse_max_targets", config.multiuse_max_targets);
+        config.enable_tribe_radial_menu = json.value("enable_tribe_radial_menu", config.enable_tribe_radial_menu);
+
+        config.debug_multiuse_log = json.value("debug_multiuse_log", config.debug_multiuse_log);
+        config.log_max_bytes = json.value("log_max_bytes", config.log_max_bytes);
+        config.log_keep_files = json.value("log_keep_files", config.log_keep_files);
+        config.stats_file_interval_seconds = json.value("stats_file_interval_seconds", config.stats_file_interval_seconds);
+        config.trace_events_per_thread = json.value("trace_events_per_thread", config.trace_events_per_thread);
+        config.timer_stage_budget_us = json.value("timer_stage_budget_us", config.timer_stage_budget_us);
+        config.config_poll_seconds = json.value("config_poll_seconds", config.config_poll_seconds);
+
+        config.self_test = json.value("self_test", config.self_test);
+        config.self_test_tribe_a = json.value("self_test_tribe_a", config.self_test_tribe_a);
+        config.self_test_tribe_b = json.value("self_test_tribe_b", config.self_test_tribe_b);
+        config.self_test_active_seconds = json.value("self_test_active_seconds", config.self_test_active_seconds);
+        config.self_test_simulate = json.value("self_test_simulate", config.self_test_simulate);
+        config.self_test_sim_seed = json.value("self_test_sim_seed", config.self_test_sim_seed);
+        config.self_test_sim_tribes = json.value("self_test_sim_tribes", config.self_test_sim_tribes);
+        config.self_test_sim_wars = json.value("self_test_sim_wars", config.self_test_sim_wars);
+        config.self_test_sim_ticks = json.value("self_test_sim_ticks", config.self_test_sim_ticks);
+    }
+    catch (const std::exception& e)
+    {
+        // Keep what was read; defaults for the rest
+        if (error)
+            *error = e.what();
+    }
+    catch (...)
+    {
+        if (error)
+            *error = "unknown error";
+    }
+    return true;
+}
+
+namespace
+{
+template <typename T>
+void AtLeast(std::vector<std::string>& fixes, const char* key, T& value, T minimum)
+{
+    if (value >= minimum)
+        return;
+    fixes.push_back(std::string(key) + "=" + std::to_string(value) + " -> " + std::to_string(minimum));
+    value = minimum;
+}
+
+void Multiplier(std::vector<std::string>& fixes, const char* key, float& value)
+{
+    if (std::isfinite(value) && value >= 0.0f)
+        return;
+    fixes.push_back(std::string(key) + " invalid -> 1.0");
+    value = 1.0f;
+}
+}
+
+std::vector<std::string> ValidateConfig(Config& config)
+{
+    std::vector<std::string> fixes;
+    AtLeast(fixes, "war_delay_seconds", config.war_delay_seconds, 0);
+    AtLeast(fixes, "cooldown_seconds", config.cooldown_seconds, 0);
+    Multiplier(fixes, "structure_damage_multiplier", config.structure_damage_multiplier);
+    AtLeast(fixes, "abandoned_structure_window_seconds", config.abandoned_structure_window_seconds, 0);
+    Multiplier(fixes, "abandoned_structure_damage_multiplier", config.abandoned_structure_damage_multiplier);
+    AtLeast(fixes, "abandoned_scan_batch", config.abandoned_scan_batch, 1);
+    AtLeast(fixes, "multiuse_max_targets", config.multiuse_max_targets, 0);
+    AtLeast(fixes, "log_max_bytes", config.log_max_bytes, int64_t(0));
+    AtLeast(fixes, "log_keep_files", config.log_keep_files, 0);
+    AtLeast(fixes, "stats_file_interval_seconds", config.stats_file_interval_seconds, 0);
+    AtLeast(fixes, "trace_events_per_thread", config.trace_events_per_thread, 64);
+    AtLeast(fixes, "timer_stage_budget_us", config.timer_stage_budget_us, 0);
+    AtLeast(fixes, "config_poll_seconds", config.config_poll_seconds, 0);
+    AtLeast(fixes, "self_test_active_seconds", config.self_test_active_seconds, 1);
+    return fixes;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Config
+{
+    int32_t war_delay_seconds = 12 * 60 * 60;
+    int32_t cooldown_seconds = 48 * 60 * 60;
+
+    // Structure damage
+    // Applied only when damage is allowed because of an active war (opposing sides).
+    // 1.0 = normal damage, 0.5 = half damage, 0.0 = no structure damage during war.
+    float structure_damage_multiplier = 1.0f;
+    std::vector<std::string> excluded_structure_blueprints;
+
+    // Abandoned tribes (tribe deleted / zero members)
+    // If a tribe has zero members, its structures become attackable by anyone for this duration.
+    bool enable_abandoned_structure_window = false;
+    int32_t abandoned_structure_window_seconds = 12 * 60 * 60;
+    float abandoned_structure_damage_multiplier = 1.0f;
+    // Tribes checked per timer tick; the whole table is covered over several ticks.
+    int32_t abandoned_scan_batch = 512;
+
+    // UI integration
+    // enable_multiuse_menu: adds actions to the existing MultiUse wheel (server-side, no client mod).
+    // enable_tribe_radial_menu: experimental, depends on client/game version.
+    bool enable_multiuse_menu = true;
+    bool multiuse_require_owned_structure = true;
+    bool multiuse_require_leader = true;
+    int32_t multiuse_max_targets = 24;
+    bool enable_tribe_radial_menu = false;
+
+    // Diagnostics
+    bool debug_multiuse_log = false;
+    // self_test.log / multiuse_debug.log rotate to .1 .. .N past this size.
+    int64_t log_max_bytes = 10 * 1024 * 1024;
+    int32_t log_keep_files = 3;
+    // How often stats.txt (hook/timer/command timings) is rewritten. 0 = only on TribeWar.Stats.
+    int32_t stats_file_interval_seconds = 300;
+    // Ring buffer size per thread for TribeWar.Trace captures (~128 bytes per event).
+    int32_t trace_events_per_thread = 16384;
+
+    // Timer tick: time slice per stage (name cache, abandoned scan, war timers,
+    // notifications, saves). Splittable stages continue on the next tick.
+    int32_t timer_stage_budget_us = 2000;
+
+    // Reload config.json when its modification time changes, checked this
+    // often. 0 = only on TribeWar.Reload / "/war admin reload".
+    int32_t config_poll_seconds = 0;
+
+    // Self-test mode: creates a synthetic war and drives it through phases
+    // so that functionality can be validated without any players.
+    bool self_test = false;
+    int64_t self_test_tribe_a = 111111;
+    int64_t self_test_tribe_b = 222222;
+    int32_t self_test_active_seconds = 15;
+    // Also runs the seeded war-lifecycle simulation (WarSimulator.h) in the background
+    // and writes its report to the self-test log. Use it as a load test before config changes.
+    bool self_test_simulate = false;
+    int64_t self_test_sim_seed = 1;
+    int32_t self_test_sim_tribes = 200;
+    int32_t self_test_sim_wars = 40;
+    int32_t self_test_sim_ticks = 2000;
+};
+
+// excluded_structure_blueprints compiled for the damage hook. Verdicts are
+// memoized per class handle in a small direct-mapped table of single atomics,
+// so any thread can read and fill it without a lock; a collision only costs a
+// fresh match against the patterns.
+class StructureExclusionMatcher
+{
+public:
+    enum class Memo : uint8_t
+    {
+        Unknown,
+        Excluded,
+        Included
+    };
+
+    // Patterns are normalized blueprint paths (see NormalizeBlueprintPath),
+    // matched as substrings.
+    explicit StructureExclusionMatcher(std::vector<std::string> patterns);
+
+    StructureExclusionMatcher(const StructureExclusionMatcher&) = delete;
+    StructureExclusionMatcher& operator=(const StructureExclusionMatcher&) = delete;
+
+    bool Empty() const
+    {
+        return patterns_.empty();
+    }
+
+    Memo Lookup(const void* structure_class) const;
+    void Remember(const void* structure_class, bool excluded) const;
+    bool MatchesPath(const std::string& normalized_path) const;
+
+private:
+    static constexpr size_t kMemoSlots = 256;
+
+    static size_t SlotOf(const void* structure_class);
+
+    std::vector<std::string> patterns_;
+    // Class handle | 1 if excluded; 0 = empty. Handles are at least 2-aligned.
+    mutable std::atomic<uintptr_t> memo_[kMemoSlots] = {};
+};
+
+// A validated Config plus what is derived from it. Never changed after it is
+// built; a reload builds a new one and swaps the pointer (see WarEngine::SetConfig).
+struct ConfigSnapshot
+{
+    explicit ConfigSnapshot(const Config& config)
+        : values(config), excluded(config.excluded_structure_blueprints)
+    {
+    }
+
+    const Config values;
+    const StructureExclusionMatcher excluded;
+};
+
+std::string ToLowerAscii(std::string value);
+
+// "Blueprint'/Game/X.X_C'" -> "/game/x.x_c"
+std::string NormalizeBlueprintPath(const std::string& path);
+
+// Returns false if the file does not exist. Parse errors keep the values read
+// so far and are reported through `error` when given.
+bool LoadConfigFile(const std::string& path, Config& config, std::string* error = nullptr);
+
+// Clamps values the engine cannot work with (negative durations, negative or
+// non-finite multipliers, empty batches). Returns one line per fixed key.
+std::vector<std::string> ValidateConfig(Config& config);
+void SaveConfigFile(const std::string& path, const Config& config);
@@ -7,9 +7,13 @@
 #include <algorithm>
 #include <chrono>
 #include <cctype>
+#include <cwchar>
+#include <deque>
 #include <fstream>
+#include <iterator>
 #include <mutex>
 #include <optional>
+#include <sstream>
 #include <atomic>
 #include <string>
 #include <unordered_map>
@@ -19,6 +23,23 @@
 #include "json.hpp"
 #include <filesystem>
 
+#include "BackgroundWorker.h"
+#include "Clock.h"
+#include "CommandLine.h"
+#include "GameWorld.h"
+#include "LockProfiler.h"
+#include "Logger.h"
+#include "MenuSessionTable.h"
+#include "PlayerAuthCache.h"
+#include "PluginStats.h"
+#include "StageScheduler.h"
+#include "Sync.h"
+#include "TribeNameStore.h"
+#include "Trace.h"
+#include "TribeWarConfig.h"
+#include "WarEngine.h"
+#include "WarSimulator.h"
+
 #pragma comment(lib, "ArkApi.lib")
 
 namespace
@@ -56,110 +77,121 @@ struct FTribeRadialMenuEntry
     bool bIsSubmenu = false;
 };
 #endif
-struct Config
-{
-    int32_t war_delay_seconds = 12 * 60 * 60;
-    int32_t cooldown_seconds = 48 * 60 * 60;
-
-    // Structure damage
-    // Applied only when damage is allowed because of an active war (opposing sides).
-    // 1.0 = normal damage, 0.5 = half damage, 0.0 = no structure damage during war.
-    float structure_damage_multiplier = 1.0f;
-    std::vector<std::string> excluded_structure_blueprints;
-
-    // Abandoned tribes (tribe deleted / zero members)
-    // If a tribe has zero members, its structures become attackable by anyone for this duration.
-    bool enable_abandoned_structure_window = false;
-    int32_t abandoned_structure_window_seconds = 12 * 60 * 60;
-    float abandoned_structure_damage_multiplier = 1.0f;
-
-    // UI integration
-    // enable_multiuse_menu: adds actions to the existing MultiUse wheel (server-side, no client mod).
-    // enable_tribe_radial_menu: experimental, depends on client/game version.
-    bool enable_multiuse_menu = true;
-    bool multiuse_require_owned_structure = true;
-    bool multiuse_require_leader = true;
-    int32_t multiuse_max_targets = 24;
-    bool enable_tribe_radial_menu = false;
-
-    // Diagnostics
-    bool debug_multiuse_log = false;
-
-    // Self-test mode: creates a synthetic war and drives it through phases
-    // so that functionality can be validated without any players.
-    bool self_test = false;
-    int64_t self_test_tribe_a = 111111;
-    int64_t self_test_tribe_b = 222222;
-    int32_t self_test_active_seconds = 15;
-};
 
-struct WarRecord
-{
-    int64_t war_id = 0;
-    int64_t tribe_a = 0;
-    int64_t tribe_b = 0;
-    int64_t declared_at = 0;
-    int64_t start_at = 0;
-    int64_t ended_at = 0;
-    int64_t cooldown_end_a = 0;
-    int64_t cooldown_end_b = 0;
-    bool cancel_requested_by_a = false;
-    bool cancel_requested_by_b = false;
-    bool start_notified = false;
-    bool cooldown_notified = false;
+// IGameWorld on top of ArkApi. Defined further down, next to the helpers it uses.
+class ArkWorld final : public IGameWorld
+{
+public:
+    bool IsReady() override;
+    bool AreTribesAllied(int64_t tribe_id, int64_t other_id) override;
+    bool IsTribeOnline(int64_t tribe_id) override;
+    int32_t GetTribeCount() override;
+    void ReadTribeMembers(int32_t begin, int32_t end, std::vector<TribeMembers>& out) override;
+    bool TryGetClassPath(const void* structure_class, std::string& out_path) override;
 };
 
-enum class WarPhase
+ArkWorld ark_world;
+TickCachedClock game_clock; // refreshed at the start of every game tick
+WarEngine war_engine(ark_world, game_clock, Config()); // wars, tribe registry, abandoned tracker; owns the live config
+
+// Live settings: the engine's current ConfigSnapshot, one atomic load. Do not
+// keep the reference across ticks; ApplyConfig swaps in a new snapshot.
+const Config& Cfg()
 {
-    None,
-    Pending,
-    Active,
-    Cooldown
-};
+    return war_engine.Cfg();
+}
 
-// std::mutex has been observed to crash in this environment (inside MSVCP140.dll).
-// Use a WinAPI SRWLOCK-based mutex to avoid STL runtime mutex internals.
-struct WinMutex
+// Interned tribe names. Entries are never removed, so references returned by
+// GetCachedTribeName/GetTribeDisplayName stay valid for the plugin lifetime.
+// Entry strings are only rewritten on the game thread, when the name changes.
+struct TribeNameEntry
 {
-    WinMutex() noexcept
-    {
-        InitializeSRWLock(&lock_);
-    }
+    FString name;
+    std::string name_utf8;
+    FString display; // "Name (ID: n)", or "ID: n" while the name is unknown
+};
 
-    void lock() noexcept
-    {
-        AcquireSRWLockExclusive(&lock_);
-    }
+std::deque<TribeNameEntry> tribe_names; // guarded by war_engine.Mutex(), indexed by TribeRegistry::name_handle
+std::vector<TribeNameDelta> tribe_name_deltas; // guarded by war_engine.Mutex(), drained by SaveTribeNameCache
+std::atomic<uint64_t> tribe_name_version{ 1 }; // bumped whenever a tribe name changes
+
+// Tribes with members, in tribe table order, from the last full pass of
+// UpdateTribeNameCache. Game thread only.
+std::vector<int64_t> tribe_roster;
+uint64_t tribe_roster_version = 0; // bumped when tribe_roster changes, 0 = no full pass yet
+
+// Tribes with a connected player, sorted by ID, as of the last
+// UpdateTribeNameCache call. Game thread only.
+std::vector<int64_t> online_tribes;
+uint64_t online_tribes_version = 0; // bumped when online_tribes changes
+
+// Declarable war targets shared by the MultiUse wheel, the radial menu and
+// /war. Rebuilt only when the war table, the roster or the tribe names change,
+// or when a cooldown runs out, so opening a menu is a filtered copy instead of
+// a tribe table walk. Game thread only; see GetDeclareTargets.
+struct DeclareTarget
+{
+    int64_t tribe_id = 0;
+    FString display;               // "Name (ID: n)"
+    FMultiUseEntry multiuse_entry; // "Объявить войну: Name (ID: n)", UseIndex set per wheel
+};
+
+struct DeclareTargetCache
+{
+    uint64_t war_version = 0;
+    uint64_t roster_version = 0;
+    uint64_t name_version = 0;
+    int64_t valid_until = 0;            // first cooldown end among the busy tribes
+    std::unordered_set<int64_t> busy;   // at war or in cooldown
+    std::vector<DeclareTarget> targets; // tribe_roster minus busy tribes
 
-    void unlock() noexcept
+    bool IsBusy(int64_t tribe_id) const
     {
-        ReleaseSRWLockExclusive(&lock_);
+        return busy.find(tribe_id) != busy.end();
     }
-
-private:
-    SRWLOCK lock_{};
 };
 
-using DataMutex = WinMutex;
-using DataLockGuard = std::lock_guard<DataMutex>;
-
-DataMutex data_mutex;
-Config config;
-std::unordered_map<int64_t, WarRecord> wars_by_id;
-std::unordered_map<int64_t, int64_t> tribe_to_war_id;
-std::unordered_map<uint64_t, std::unordered_map<int, int64_t>> declare_targets;
-std::unordered_map<int64_t, int64_t> abandoned_tribe_until; // tribe_id -> unix_ts
-std::unordered_map<int64_t, FString> tribe_name_cache;
-std::atomic<bool> tribe_name_dirty { false };
+DeclareTargetCache declare_target_cache;
+
+// File writes that should not stall the game thread (tribe name log, logs, stats).
+BackgroundWorker io_worker;
+TribeNameStore tribe_name_store; // owned by io_worker once started
+LogChannel self_test_log("self_test", game_clock, io_worker); // self_test.log, on while config.self_test
+LogChannel multiuse_log("multiuse", game_clock, io_worker);   // multiuse_debug.log, on while config.debug_multiuse_log
+std::atomic<bool> self_test_sim_cancel{ false }; // stops a running simulation on unload
+StageScheduler timer_stages;                      // TimerCallback stages, set up by InitPlugin
+int64_t trace_stop_at = 0;                        // end of a timed TribeWar.Trace capture, 0 = none
+
+// What each UseIndex / radial EntryID of a player's last plugin menu does.
+MenuSessionTable menu_sessions;
+PlayerAuthCache player_auth; // IsTribeLeaderOrAdmin verdicts, new generation every TimerCallback
+static_assert(3 + kMenuDeclareListMax <= MenuSession::kMaxEntries, "menu session too small for a full declare list");
+
+// Plugin entries of the last MultiUse wheel built for a player. Clients ask
+// for the entries again and again while the wheel is open; for the same
+// structure, within kMultiUseMenuCacheSeconds and with nothing they were built
+// from changed, the copy is handed back and the session is left as it is.
+// Game thread only.
+constexpr int64_t kMultiUseMenuCacheSeconds = 2;
+
+struct MultiUseMenuCache
+{
+    const APrimalStructure* structure = nullptr;
+    int64_t tribe_id = 0;
+    int first_index = 0;             // UseIndex of the first plugin entry
+    uint32_t session_generation = 0; // menu_sessions generation holding these indices
+    uint64_t war_version = 0;        // declare_target_cache stamp
+    uint64_t roster_version = 0;
+    uint64_t name_version = 0;
+    int64_t targets_valid_until = 0;
+    int64_t built_at = 0;
+    std::vector<FMultiUseEntry> entries;
+};
 
-// Dynamic UseIndex mapping: for each player, store what UseIndex maps to what action.
-// action codes: 1=status, 2=cancel, 3=accept_cancel, 100+N=declare_target[N]
-std::unordered_map<uint64_t, std::unordered_map<int, int>> multiuse_action_map;
+std::unordered_map<uint64_t, MultiUseMenuCache> multiuse_menu_cache;
 
-int64_t next_war_id = 1;
-bool auto_timers_enabled = true;
 bool plugin_initialized = false;
-std::atomic<bool> need_save { false };
+bool plugin_unloaded = false; // Unload ran (Plugin_Unload, then again from DllMain)
 struct PendingNotification
 {
     int64_t side_tribe_id = 0;
@@ -171,7 +203,7 @@ struct PendingNotification
 };
 
 std::vector<PendingNotification> pending_notifications;
-DataMutex notification_mutex;
+DataMutex notification_mutex{ "notification_mutex" };
 
 
 std::string GetPluginDir()
@@ -194,31 +226,17 @@ std::string GetTribeNameCachePath()
     return GetPluginDir() + "/tribe_names.json";
 }
 
+std::string GetTribeNameLogPath()
+{
+    return GetPluginDir() + "/tribe_names.log";
+}
+
 AShooterPlayerState* GetPlayerState(AShooterPlayerController* pc);
-int64_t CanonicalTribeId(int64_t raw_id);
 int64_t GetTribeIdFromPlayer(AShooterPlayerController* pc);
 bool TryGetPathNameSafe(UObject* obj, FString* out_path);
 bool TryGetTribeNameSafe(FTribeData* data, FString* out_name);
 int32_t TryGetTribeMemberCount(FTribeData& data, int32_t& out_tribe_id);
 
-std::string ToLowerAscii(std::string value)
-{
-    std::transform(value.begin(), value.end(), value.begin(),
-        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    return value;
-}
-
-std::string NormalizeBlueprintPath(const std::string& path)
-{
-    std::string lower = ToLowerAscii(path);
-    const std::string prefix = "blueprint'";
-    if (lower.rfind(prefix, 0) == 0)
-        lower = lower.substr(prefix.size());
-    if (!lower.empty() && lower.back() == '\'')
-        lower.pop_back();
-    return lower;
-}
-
 bool TryGetPathNameSafe(UObject* obj, FString* out_path)
 {
     if (!obj || !out_path)
@@ -264,40 +282,63 @@ std::string GetMultiUseDebugLogPath()
     return GetPluginDir() + "/multiuse_debug.log";
 }
 
+std::string GetStatsPath()
+{
+    return GetPluginDir() + "/stats.txt";
+}
+
 bool FileExists(const std::string& path)
 {
     std::error_code ec;
     return std::filesystem::exists(std::filesystem::path(path), ec);
 }
 
-void LoadTribeNameCache()
+TribeNameEntry& InternTribeNameLocked(int64_t tribe_id)
 {
-    try
-    {
-        if (!FileExists(GetTribeNameCachePath()))
-            return;
+    auto& registry = war_engine.RegistryLocked();
+    auto& handle = registry.name_handle[registry.Intern(tribe_id)];
+    if (handle != kNoNameHandle)
+        return tribe_names[handle];
 
-        std::ifstream file(GetTribeNameCachePath(), std::ios::in | std::ios::binary);
-        if (!file.is_open())
-            return;
+    handle = static_cast<uint32_t>(tribe_names.size());
+    tribe_names.emplace_back();
+    auto& entry = tribe_names.back();
+    entry.display = FString::Format(L"ID: {}", tribe_id);
+    return entry;
+}
 
-        const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        const auto json = nlohmann::json::parse(content, nullptr, false);
-        if (json.is_discarded())
-            return;
+const TribeNameEntry* FindTribeNameLocked(int64_t tribe_id)
+{
+    const auto& registry = war_engine.RegistryLocked();
+    const auto index = registry.Find(tribe_id);
+    if (index == kNoTribeIndex || registry.name_handle[index] == kNoNameHandle)
+        return nullptr;
+    return &tribe_names[registry.name_handle[index]];
+}
 
-        if (json.find("names") == json.end() || !json["names"].is_object())
-            return;
+void SetTribeNameLocked(TribeNameEntry& entry, int64_t tribe_id, const FString& name, std::string name_utf8)
+{
+    entry.name = name;
+    entry.name_utf8 = std::move(name_utf8);
+    entry.display = FString::Format(L"{} (ID: {})", *entry.name, tribe_id);
+    tribe_name_version.fetch_add(1, std::memory_order_relaxed);
+}
 
-        DataLockGuard lock(data_mutex);
-        tribe_name_cache.clear();
-        for (auto it = json["names"].begin(); it != json["names"].end(); ++it)
-        {
-            if (!it.value().is_string())
-                continue;
-            const int64_t id = CanonicalTribeId(std::stoll(it.key()));
-            tribe_name_cache[id] = FString(it.value().get<std::string>().c_str());
-        }
+// Must run before io_worker is started: the store is not shared with the worker yet.
+void LoadTribeNameCache()
+{
+    try
+    {
+        tribe_name_store.Open(GetTribeNameCachePath(), GetTribeNameLogPath());
+        const auto names = tribe_name_store.Load();
+
+        DataLockGuard lock(war_engine.Mutex());
+        tribe_names.clear();
+        for (auto& handle : war_engine.RegistryLocked().name_handle)
+            handle = kNoNameHandle;
+        tribe_name_deltas.clear();
+        for (const auto& it : names)
+            SetTribeNameLocked(InternTribeNameLocked(it.first), it.first, FString(it.second.c_str()), it.second);
     }
     catch (...)
     {
@@ -305,40 +346,33 @@ void LoadTribeNameCache()
     }
 }
 
+// Hands name changes since the last call to the worker, which appends them to the delta log.
 void SaveTribeNameCache()
 {
-    if (!tribe_name_dirty.exchange(false))
-        return;
-
-    try
-    {
-        nlohmann::json json;
-        nlohmann::json names = nlohmann::json::object();
-        {
-            DataLockGuard lock(data_mutex);
-            for (const auto& it : tribe_name_cache)
-                names[std::to_string(it.first)] = it.second.ToString();
-        }
-        json["names"] = std::move(names);
-
-        std::filesystem::create_directories(std::filesystem::path(GetTribeNameCachePath()).parent_path());
-        std::ofstream file(GetTribeNameCachePath(), std::ios::trunc);
-        file << json.dump(2);
-    }
-    catch (...)
+    std::vector<TribeNameDelta> deltas;
     {
-        // ignore
+        DataLockGuard lock(war_engine.Mutex());
+        if (tribe_name_deltas.empty())
+            return;
+        deltas.swap(tribe_name_deltas);
     }
+
+    io_worker.Post([deltas = std::move(deltas)]() { tribe_name_store.Append(deltas); });
 }
 
-FString GetCachedTribeName(int64_t tribe_id)
+void CompactTribeNameCache()
 {
+    SaveTribeNameCache();
+    io_worker.Post([]() { tribe_name_store.Compact(); });
+}
+
+const FString& GetCachedTribeName(int64_t tribe_id)
+{
+    static const FString empty;
     tribe_id = CanonicalTribeId(tribe_id);
-    DataLockGuard lock(data_mutex);
-    auto it = tribe_name_cache.find(tribe_id);
-    if (it == tribe_name_cache.end())
-        return FString();
-    return it->second;
+    DataLockGuard lock(war_engine.Mutex());
+    const auto* entry = FindTribeNameLocked(tribe_id);
+    return entry ? entry->name : empty;
 }
 
 void CacheTribeName(int64_t tribe_id, const FString& name)
@@ -347,19 +381,16 @@ void CacheTribeName(int64_t tribe_id, const FString& name)
         return;
 
     tribe_id = CanonicalTribeId(tribe_id);
-    bool updated = false;
-    {
-        DataLockGuard lock(data_mutex);
-        auto it = tribe_name_cache.find(tribe_id);
-        if (it == tribe_name_cache.end() || it->second != name)
-        {
-            tribe_name_cache[tribe_id] = name;
-            updated = true;
-        }
-    }
+    DataLockGuard lock(war_engine.Mutex());
+    auto& entry = InternTribeNameLocked(tribe_id);
+    if (entry.name == name)
+        return;
+    SetTribeNameLocked(entry, tribe_id, name, name.ToString());
 
-    if (updated)
-        tribe_name_dirty.store(true);
+    TribeNameDelta delta;
+    delta.tribe_id = tribe_id;
+    delta.name = entry.name_utf8;
+    tribe_name_deltas.push_back(std::move(delta));
 }
 
 bool TryResolveTribeName(int64_t tribe_id, FString& out_name)
@@ -427,31 +458,45 @@ bool TryResolveTribeName(int64_t tribe_id, FString& out_name)
     return false;
 }
 
-FString GetTribeDisplayName(int64_t tribe_id)
+// "Name (ID: n)", formatted once per name change. Falls back to "ID: n".
+const FString& GetTribeDisplayName(int64_t tribe_id)
 {
-    FString name;
-    if (!TryResolveTribeName(tribe_id, name))
-        name = GetCachedTribeName(tribe_id);
-
-    if (!name.IsEmpty())
+    tribe_id = CanonicalTribeId(tribe_id);
     {
-        CacheTribeName(tribe_id, name);
-        return FString::Format(L"{} (ID: {})", *name, tribe_id);
+        DataLockGuard lock(war_engine.Mutex());
+        const auto& entry = InternTribeNameLocked(tribe_id);
+        if (!entry.name.IsEmpty())
+            return entry.display;
     }
-    return FString::Format(L"ID: {}", CanonicalTribeId(tribe_id));
+
+    // Unknown name: try live lookup once more (caches on success).
+    FString name;
+    TryResolveTribeName(tribe_id, name);
+
+    DataLockGuard lock(war_engine.Mutex());
+    return InternTribeNameLocked(tribe_id).display;
 }
 
-void UpdateTribeNameCache()
+// Online players first, then the tribe table from where the last call stopped.
+// Returns false if the deadline cut the table walk short.
+bool UpdateTribeNameCache(const StageDeadline& deadline)
 {
+    static int32_t tribe_table_cursor = 0;
+    static std::vector<int64_t> roster_pass; // tribe_roster as seen so far in this pass
+    static std::unordered_set<int64_t> roster_pass_ids;
+
     if (ArkApi::GetApiUtils().GetStatus() != ArkApi::ServerStatus::Ready)
-        return;
+        return true;
 
     auto* world = ArkApi::GetApiUtils().GetWorld();
     if (!world)
-        return;
+        return true;
 
     auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
 
+    static std::vector<int64_t> online_pass;
+    online_pass.clear();
+
     auto& players = world->PlayerControllerListField();
     for (TWeakObjectPtr<APlayerController>& player : players)
     {
@@ -463,6 +508,10 @@ void UpdateTribeNameCache()
         if (tribe_id == 0)
             continue;
 
+        // Only fully connected players count as online (not disconnected/pending)
+        if (pc->IsValidLowLevelFast(true) && pc->IsA(AShooterPlayerController::StaticClass()))
+            online_pass.push_back(tribe_id);
+
         FString name;
         if (auto* ps = GetPlayerState(pc))
         {
@@ -480,27 +529,36 @@ void UpdateTribeNameCache()
         if (name.IsEmpty())
             continue;
 
-        bool updated = false;
-        {
-            DataLockGuard lock(data_mutex);
-            auto it = tribe_name_cache.find(tribe_id);
-            if (it == tribe_name_cache.end() || it->second != name)
-            {
-                tribe_name_cache[tribe_id] = name;
-                updated = true;
-            }
-        }
+        CacheTribeName(tribe_id, name);
+    }
 
-        if (updated)
-            tribe_name_dirty.store(true);
+    std::sort(online_pass.begin(), online_pass.end());
+    online_pass.erase(std::unique(online_pass.begin(), online_pass.end()), online_pass.end());
+    if (online_pass != online_tribes)
+    {
+        online_tribes.swap(online_pass);
+        ++online_tribes_version;
     }
 
     // Fallback: best-effort fill from TribesDataField (covers offline tribes).
     if (game_mode)
     {
         const auto& tribes = game_mode->TribesDataField();
-        for (int i = 0; i < tribes.Num(); ++i)
+        if (tribe_table_cursor >= tribes.Num())
+            tribe_table_cursor = 0;
+        if (tribe_table_cursor == 0)
+        {
+            roster_pass.clear();
+            roster_pass_ids.clear();
+        }
+        for (int i = tribe_table_cursor; i < tribes.Num(); ++i)
         {
+            if ((i - tribe_table_cursor) % 64 == 63 && deadline.Expired())
+            {
+                tribe_table_cursor = i;
+                return false;
+            }
+
             auto& data = const_cast<FTribeData&>(tribes[i]);
             int32_t tid = 0;
             const int32_t members = TryGetTribeMemberCount(data, tid);
@@ -508,261 +566,166 @@ void UpdateTribeNameCache()
                 continue;
 
             const int64_t tribe_id = CanonicalTribeId(static_cast<int64_t>(tid));
+            if (members > 0 && roster_pass_ids.insert(tribe_id).second)
+                roster_pass.push_back(tribe_id);
+
             FString name;
             if (!TryGetTribeNameSafe(&data, &name) || name.IsEmpty())
                 continue;
 
-            bool updated = false;
-            {
-                DataLockGuard lock(data_mutex);
-                auto it = tribe_name_cache.find(tribe_id);
-                if (it == tribe_name_cache.end() || it->second != name)
-                {
-                    tribe_name_cache[tribe_id] = name;
-                    updated = true;
-                }
-            }
+            CacheTribeName(tribe_id, name);
+        }
 
-            if (updated)
-                tribe_name_dirty.store(true);
+        if (tribe_roster_version == 0 || roster_pass != tribe_roster)
+        {
+            tribe_roster.swap(roster_pass);
+            ++tribe_roster_version;
         }
     }
-}
-
-int64_t Now();
 
-void AppendSelfTestLog(const std::string& message)
-{
-    if (!config.self_test)
-        return;
-
-    try
-    {
-        std::filesystem::create_directories(std::filesystem::path(GetSelfTestLogPath()).parent_path());
-        std::ofstream f(GetSelfTestLogPath(), std::ios::app);
-        if (!f.is_open())
-            return;
-        f << Now() << " " << message << "\n";
-    }
-    catch (...)
-    {
-    }
+    tribe_table_cursor = 0;
+    return true;
 }
 
-void AppendMultiUseDebugLog(const std::string& message)
+// A plugin wheel entry without its UseIndex. Wheel entries are copied from
+// these templates, so a wheel open does not fill entries or format labels.
+FMultiUseEntry MakeMultiUseEntry(const FString& text, int priority = 0)
 {
-    if (!config.debug_multiuse_log)
-        return;
-
-    try
-    {
-        std::filesystem::create_directories(std::filesystem::path(GetMultiUseDebugLogPath()).parent_path());
-        std::ofstream f(GetMultiUseDebugLogPath(), std::ios::app);
-        if (!f.is_open())
-            return;
-        f << Now() << " " << message << "\n";
-    }
-    catch (...)
-    {
+    FMultiUseEntry e;
+    memset(&e, 0, sizeof(e));
+    e.ForComponent = nullptr; // CRITICAL: must be valid pointer or nullptr
+    e.UseString = text;
+    e.UseIndex = 0;
+    e.Priority = priority;
+    e.bHideFromUI = 0;
+    e.bDisableUse = 0;
+    e.WheelCategory = 0;
+    e.DisableUseColor = FColor(0, 0, 0, 0);
+    e.UseTextColor = FColor(255, 255, 255, 255);
+    e.EntryActivationTimer = 0.0f;
+    e.DefaultEntryActivationTimer = 0.0f;
+    e.ActivationSound = nullptr;
+    e.UseInventoryButtonStyleOverrideIndex = 0;
+    return e;
+}
+
+// Up-to-date declare_target_cache. Names come from the name table as they are
+// (no live lookups); UpdateTribeNameCache fills in the missing ones.
+const DeclareTargetCache& GetDeclareTargets(int64_t now)
+{
+    // A menu opened before the timer finished its first pass over the tribe table.
+    if (tribe_roster_version == 0)
+        UpdateTribeNameCache(StageDeadline::Unbounded());
+
+    auto& cache = declare_target_cache;
+    const auto war_version = war_engine.WarStateVersion();
+    const auto name_version = tribe_name_version.load(std::memory_order_relaxed);
+    if (cache.war_version == war_version && cache.roster_version == tribe_roster_version && cache.name_version == name_version &&
+        now < cache.valid_until)
+        return cache;
+
+    cache.war_version = war_version;
+    cache.roster_version = tribe_roster_version;
+    cache.name_version = name_version;
+    cache.busy.clear();
+    cache.targets.clear();
+
+    std::vector<int64_t> busy;
+    DataLockGuard lock(war_engine.Mutex());
+    cache.valid_until = war_engine.CollectBusyTribesLocked(now, busy);
+    cache.busy.insert(busy.begin(), busy.end());
+    cache.targets.reserve(tribe_roster.size());
+    for (const auto tribe_id : tribe_roster)
+    {
+        if (cache.IsBusy(tribe_id))
+            continue;
+        DeclareTarget target;
+        target.tribe_id = tribe_id;
+        target.display = InternTribeNameLocked(tribe_id).display;
+        target.multiuse_entry = MakeMultiUseEntry(FString::Format(L"Объявить войну: {}", *target.display));
+        cache.targets.push_back(std::move(target));
     }
+    return cache;
 }
 
-int64_t Now()
+// Online declare targets for /war list and /war find, sorted by lowercased
+// tribe name (unnamed tribes last, by ID). Rebuilt only when the online set,
+// the war table or the names change, or a cooldown runs out; a request then
+// formats one page from it. Game thread only; see GetOnlineTargets.
+struct OnlineTarget
 {
-    return std::chrono::duration_cast<std::chrono::seconds>(
-               std::chrono::system_clock::now().time_since_epoch())
-        .count();
-}
+    int64_t tribe_id = 0;
+    FString key;                               // lowercased name, empty if unknown
+    const TribeNameEntry* name_entry = nullptr; // interned, stays valid
+};
 
-int64_t CanonicalTribeId(int64_t raw_id)
+struct OnlineTargetIndex
 {
-    // ARK tribe/team IDs are effectively 32-bit values.
-    // Normalize to unsigned 32-bit to avoid negative IDs in UI and comparisons.
-    const auto as_i32 = static_cast<int32_t>(raw_id);
-    const auto as_u32 = static_cast<uint32_t>(as_i32);
-    return static_cast<int64_t>(as_u32);
-}
+    uint64_t online_version = 0;
+    uint64_t war_version = 0;
+    uint64_t name_version = 0;
+    int64_t valid_until = 0;
+    std::vector<OnlineTarget> targets;
+};
+
+OnlineTargetIndex online_target_index;
 
-WarPhase GetPhase(const WarRecord& war, int64_t now)
+const OnlineTargetIndex& GetOnlineTargets(int64_t now)
 {
-    if (war.war_id == 0)
-        return WarPhase::None;
+    const auto& declare = GetDeclareTargets(now);
+    auto& index = online_target_index;
+    if (index.online_version == online_tribes_version && index.war_version == declare.war_version &&
+        index.name_version == declare.name_version && index.valid_until == declare.valid_until)
+        return index;
 
-    if (war.ended_at == 0)
+    index.online_version = online_tribes_version;
+    index.war_version = declare.war_version;
+    index.name_version = declare.name_version;
+    index.valid_until = declare.valid_until;
+    index.targets.clear();
     {
-        if (now < war.start_at)
-            return WarPhase::Pending;
-        return WarPhase::Active;
+        DataLockGuard lock(war_engine.Mutex());
+        for (const auto tribe_id : online_tribes)
+        {
+            if (declare.IsBusy(tribe_id))
+                continue;
+            OnlineTarget target;
+            target.tribe_id = tribe_id;
+            target.name_entry = &InternTribeNameLocked(tribe_id);
+            target.key = target.name_entry->name.ToLower();
+            index.targets.push_back(std::move(target));
+        }
     }
-
-    if (now < war.cooldown_end_a || now < war.cooldown_end_b)
-        return WarPhase::Cooldown;
-
-    return WarPhase::None;
-}
-
-bool IsActiveWar(const WarRecord& war, int64_t now)
-{
-    return GetPhase(war, now) == WarPhase::Active;
+    std::sort(index.targets.begin(), index.targets.end(), [](const OnlineTarget& a, const OnlineTarget& b) {
+        if (a.key.IsEmpty() != b.key.IsEmpty())
+            return b.key.IsEmpty();
+        const int order = std::wcscmp(*a.key, *b.key);
+        return order != 0 ? order < 0 : a.tribe_id < b.tribe_id;
+    });
+    return index;
 }
 
-void RebuildTribeIndexLocked(int64_t now)
+int64_t Now()
 {
-    tribe_to_war_id.clear();
-    for (const auto& it : wars_by_id)
-    {
-        const auto& war = it.second;
-        const auto phase = GetPhase(war, now);
-        if (phase == WarPhase::None)
-            continue;
-        tribe_to_war_id[war.tribe_a] = war.war_id;
-        tribe_to_war_id[war.tribe_b] = war.war_id;
-    }
+    return game_clock.Now();
 }
 
 void SaveData()
 {
-    try
-    {
-        int64_t snapshot_next_war_id = 1;
-        std::vector<WarRecord> snapshot_wars;
-        {
-            DataLockGuard lock(data_mutex);
-            snapshot_next_war_id = next_war_id;
-            snapshot_wars.reserve(wars_by_id.size());
-            for (const auto& it : wars_by_id)
-                snapshot_wars.push_back(it.second);
-        }
-
-        const auto path = GetDataPath();
-        std::filesystem::create_directories(
-            std::filesystem::path(path).parent_path()
-        );
-
-        std::ofstream file(path, std::ios::trunc);
-        if (!file.is_open())
-        {
-            AppendSelfTestLog("SaveData: failed to open data.json");
-            return;
-        }
-
-        nlohmann::json json;
-        json["next_war_id"] = snapshot_next_war_id;
-        json["wars"] = nlohmann::json::array();
-
-        for (const auto& war : snapshot_wars)
-        {
-            nlohmann::json item;
-            item["war_id"] = war.war_id;
-            item["tribe_a"] = war.tribe_a;
-            item["tribe_b"] = war.tribe_b;
-            item["declared_at"] = war.declared_at;
-            item["start_at"] = war.start_at;
-            item["ended_at"] = war.ended_at;
-            item["cooldown_end_a"] = war.cooldown_end_a;
-            item["cooldown_end_b"] = war.cooldown_end_b;
-            item["cancel_requested_by_a"] = war.cancel_requested_by_a;
-            item["cancel_requested_by_b"] = war.cancel_requested_by_b;
-            item["start_notified"] = war.start_notified;
-            item["cooldown_notified"] = war.cooldown_notified;
-            json["wars"].push_back(item);
-        }
-
-        file << json.dump(2);
-        AppendSelfTestLog("SaveData: wrote data.json (wars=" + std::to_string(snapshot_wars.size()) + ")");
-    }
-    catch (...)
-    {
-        // Silent fail to avoid crash
-        AppendSelfTestLog("SaveData: exception");
-    }
+    StatScope stat(Stat::SaveData);
+    war_engine.SaveData(GetDataPath());
 }
 
 void LoadData()
 {
-    try
-    {
-        std::ifstream file(GetDataPath(), std::ios::in | std::ios::binary);
-        if (!file.is_open())
-            return;
-
-        const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        const auto json = nlohmann::json::parse(content, nullptr, false);
-        if (json.is_discarded())
-            return;
-
-        int64_t loaded_next_war_id = json.value("next_war_id", static_cast<int64_t>(1));
-
-        std::vector<WarRecord> loaded_wars;
-        const int64_t now = Now();
-        const int64_t max_cooldown = config.cooldown_seconds * 2 + 3600; // allow 2x cooldown + 1hr buffer
-
-        if (json.find("wars") != json.end())
-        {
-            for (const auto& item : json["wars"])
-            {
-                WarRecord war;
-                war.war_id = item.value("war_id", 0);
-                war.tribe_a = CanonicalTribeId(item.value("tribe_a", static_cast<int64_t>(0)));
-                war.tribe_b = CanonicalTribeId(item.value("tribe_b", static_cast<int64_t>(0)));
-                war.declared_at = item.value("declared_at", 0);
-                war.start_at = item.value("start_at", 0);
-                war.ended_at = item.value("ended_at", 0);
-                war.cooldown_end_a = item.value("cooldown_end_a", 0);
-                war.cooldown_end_b = item.value("cooldown_end_b", 0);
-                war.cancel_requested_by_a = item.value("cancel_requested_by_a", false);
-                war.cancel_requested_by_b = item.value("cancel_requested_by_b", false);
-                war.start_notified = item.value("start_notified", false);
-                war.cooldown_notified = item.value("cooldown_notified", false);
-                
-                if (war.war_id <= 0)
-                    continue;
-                if (war.tribe_a == 0 || war.tribe_b == 0)
-                    continue;
-                    
-                // BUGFIX: Ignore expired wars (avoid stale data from file)
-                // If war is ended and both cooldowns are expired, skip it
-                if (war.ended_at != 0)
-                {
-                    if (war.cooldown_end_a > 0 && war.cooldown_end_b > 0 &&
-                        now >= war.cooldown_end_a && now >= war.cooldown_end_b)
-                    {
-                        // War is completely done, discard it
-                        continue;
-                    }
-                    // Also discard if war is WAY too old (data corruption safety)
-                    if (war.declared_at > 0 && now - war.declared_at > max_cooldown)
-                        continue;
-                }
-                
-                loaded_wars.push_back(war);
-            }
-        }
-
-        {
-            DataLockGuard lock(data_mutex);
-            wars_by_id.clear();
-            tribe_to_war_id.clear();
-            next_war_id = loaded_next_war_id;
-            for (const auto& war : loaded_wars)
-                wars_by_id[war.war_id] = war;
-            RebuildTribeIndexLocked(Now());
-        }
-    }
-    catch (...)
-    {
-        DataLockGuard lock(data_mutex);
-        wars_by_id.clear();
-        tribe_to_war_id.clear();
-        next_war_id = 1;
-    }
+    war_engine.LoadData(GetDataPath(), Now());
 }
 
 void FlushSaveIfNeeded()
 {
     static int64_t last_save = 0;
     const auto now = Now();
-    if (!need_save.exchange(false))
+    if (!war_engine.ConsumeDirty())
         return;
     if (now - last_save < 30)
         return;
@@ -772,111 +735,29 @@ void FlushSaveIfNeeded()
 
 void SaveConfig()
 {
-    std::ofstream file(GetConfigPath(), std::ios::trunc);
-    nlohmann::json json;
-    json["war_delay_seconds"] = config.war_delay_seconds;
-    json["cooldown_seconds"] = config.cooldown_seconds;
-    json["structure_damage_multiplier"] = config.structure_damage_multiplier;
-    json["excluded_structure_blueprints"] = config.excluded_structure_blueprints;
-    json["enable_abandoned_structure_window"] = config.enable_abandoned_structure_window;
-    json["abandoned_structure_window_seconds"] = config.abandoned_structure_window_seconds;
-    json["abandoned_structure_damage_multiplier"] = config.abandoned_structure_damage_multiplier;
-
-    json["enable_multiuse_menu"] = config.enable_multiuse_menu;
-    json["multiuse_require_owned_structure"] = config.multiuse_require_owned_structure;
-    json["multiuse_require_leader"] = config.multiuse_require_leader;
-    json["multiuse_max_targets"] = config.multiuse_max_targets;
-    json["enable_tribe_radial_menu"] = config.enable_tribe_radial_menu;
-
-    json["debug_multiuse_log"] = config.debug_multiuse_log;
-
-    json["self_test"] = config.self_test;
-    json["self_test_tribe_a"] = config.self_test_tribe_a;
-    json["self_test_tribe_b"] = config.self_test_tribe_b;
-    json["self_test_active_seconds"] = config.self_test_active_seconds;
-
-    file << json.dump(2);
+    SaveConfigFile(GetConfigPath(), Cfg());
 }
 
-void LoadConfig()
+// Makes `snapshot` the live config. Game thread only; hooks on other threads
+// see it on their next Cfg() call.
+void ApplyConfig(std::shared_ptr<const ConfigSnapshot> snapshot)
 {
-    try
-    {
-        std::ifstream file(GetConfigPath());
-        if (!file.is_open())
-        {
-            SaveConfig();
-            return;
-        }
-
-        nlohmann::json json;
-        file >> json;
-        config.war_delay_seconds = json.value("war_delay_seconds", config.war_delay_seconds);
-        config.cooldown_seconds = json.value("cooldown_seconds", config.cooldown_seconds);
-        config.structure_damage_multiplier = json.value("structure_damage_multiplier", config.structure_damage_multiplier);
-        config.excluded_structure_blueprints.clear();
-        if (json.find("excluded_structure_blueprints") != json.end() && json["excluded_structure_blueprints"].is_array())
-        {
-            for (const auto& item : json["excluded_structure_blueprints"])
-            {
-                if (!item.is_string())
-                    continue;
-                const auto normalized = NormalizeBlueprintPath(item.get<std::string>());
-                if (!normalized.empty())
-                    config.excluded_structure_blueprints.push_back(normalized);
-            }
-        }
-        config.enable_abandoned_structure_window = json.value("enable_abandoned_structure_window", config.enable_abandoned_structure_window);
-        config.abandoned_structure_window_seconds = json.value("abandoned_structure_window_seconds", config.abandoned_structure_window_seconds);
-        config.abandoned_structure_damage_multiplier = json.value("abandoned_structure_damage_multiplier", config.abandoned_structure_damage_multiplier);
-
-        config.enable_multiuse_menu = json.value("enable_multiuse_menu", config.enable_multiuse_menu);
-        config.multiuse_require_owned_structure = json.value("multiuse_require_owned_structure", config.multiuse_require_owned_structure);
-        config.multiuse_require_leader = json.value("multiuse_require_leader", config.multiuse_require_leader);
-        config.multiuse_max_targets = json.value("multiuse_max_targets", config.multiuse_max_targets);
-        config.enable_tribe_radial_menu = json.value("enable_tribe_radial_menu", config.enable_tribe_radial_menu);
-
-        config.debug_multiuse_log = json.value("debug_multiuse_log", config.debug_multiuse_log);
-
-        config.self_test = json.value("self_test", config.self_test);
-        config.self_test_tribe_a = json.value("self_test_tribe_a", config.self_test_tribe_a);
-        config.self_test_tribe_b = json.value("self_test_tribe_b", config.self_test_tribe_b);
-        config.self_test_active_seconds = json.value("self_test_active_seconds", config.self_test_active_seconds);
-    }
-    catch (...)
-    {
-        // Silent fail, use defaults
-    }
+    war_engine.SetConfig(std::move(snapshot));
+    self_test_log.SetEnabled(Cfg().self_test);
+    multiuse_log.SetEnabled(Cfg().debug_multiuse_log);
+    multiuse_menu_cache.clear(); // wheels built under the old limits
 }
 
-void SeedSelfTestWarIfNeeded()
+// Startup load; writes the defaults when config.json is missing. Returns the
+// values ValidateConfig had to fix, for the log once it is open.
+std::vector<std::string> LoadConfig()
 {
-    if (!config.self_test)
-        return;
-
-    const auto now = Now();
-
-    DataLockGuard lock(data_mutex);
-    if (!wars_by_id.empty())
-        return;
-
-    const auto a = config.self_test_tribe_a;
-    const auto b = config.self_test_tribe_b;
-    if (a == 0 || b == 0 || a == b)
-        return;
-
-    WarRecord war;
-    war.war_id = next_war_id++;
-    war.tribe_a = a;
-    war.tribe_b = b;
-    war.declared_at = now;
-    war.start_at = now + config.war_delay_seconds;
-    wars_by_id[war.war_id] = war;
-    RebuildTribeIndexLocked(now);
-
-    AppendSelfTestLog("SeedSelfTestWar: created war_id=" + std::to_string(war.war_id) +
-                      " a=" + std::to_string(a) + " b=" + std::to_string(b) +
-                      " start_in=" + std::to_string(config.war_delay_seconds) + "s");
+    Config loaded;
+    if (!LoadConfigFile(GetConfigPath(), loaded))
+        SaveConfigFile(GetConfigPath(), loaded);
+    auto fixes = ValidateConfig(loaded);
+    ApplyConfig(std::make_shared<const ConfigSnapshot>(loaded));
+    return fixes;
 }
 
 int64_t GetTribeIdFromActor(AActor* actor)
@@ -937,122 +818,25 @@ int32_t TryGetTribeMemberCount(FTribeData& data, int32_t& out_tribe_id)
     }
 }
 
-void UpdateAbandonedTribes(int64_t now)
+AShooterPlayerState* GetPlayerState(AShooterPlayerController* pc)
 {
-    if (!config.enable_abandoned_structure_window)
-        return;
-
-    if (ArkApi::GetApiUtils().GetStatus() != ArkApi::ServerStatus::Ready)
-        return;
+    if (!pc)
+        return nullptr;
+    return pc->GetShooterPlayerState();
+}
 
-    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
-    if (!game_mode)
-        return;
+uint64_t GetPlayerKey(AShooterPlayerController* pc)
+{
+    if (!pc)
+        return 0;
+    return ArkApi::IApiUtils::GetSteamIdFromController(pc);
+}
 
-    const int32_t window = (std::max)(0, config.abandoned_structure_window_seconds);
-    if (window <= 0)
-        return;
-
-    try
-    {
-        const auto& tribes = game_mode->TribesDataField();
-        DataLockGuard lock(data_mutex);
-
-        // Cleanup expired entries (keep map small).
-        for (auto it = abandoned_tribe_until.begin(); it != abandoned_tribe_until.end();)
-        {
-            if (it->second <= now)
-                it = abandoned_tribe_until.erase(it);
-            else
-                ++it;
-        }
-
-        for (int i = 0; i < tribes.Num(); ++i)
-        {
-            auto& data = const_cast<FTribeData&>(tribes[i]);
-            int32_t tid = 0;
-            const int32_t members = TryGetTribeMemberCount(data, tid);
-            if (tid <= 0 || members < 0)
-                continue;
-
-            if (members == 0)
-            {
-                // Start/refresh the window from "now" when tribe is observed as empty.
-                abandoned_tribe_until[CanonicalTribeId(static_cast<int64_t>(tid))] = now + window;
-            }
-            else
-            {
-                abandoned_tribe_until.erase(CanonicalTribeId(static_cast<int64_t>(tid)));
-            }
-        }
-    }
-    catch (...)
-    {
-        // ignore
-    }
-}
-
-bool IsAbandonedStructureVulnerable(int64_t target_tribe_id, int64_t now, float& out_multiplier)
-{
-    out_multiplier = 1.0f;
-    if (!config.enable_abandoned_structure_window)
-        return false;
-    target_tribe_id = CanonicalTribeId(target_tribe_id);
-    if (target_tribe_id == 0)
-        return false;
-
-    const float mult = config.abandoned_structure_damage_multiplier;
-    DataLockGuard lock(data_mutex);
-    auto it = abandoned_tribe_until.find(target_tribe_id);
-    if (it == abandoned_tribe_until.end())
-        return false;
-    if (it->second <= now)
-        return false;
-
-    out_multiplier = mult;
-    return true;
-}
-
-bool IsExcludedStructure(APrimalStructure* structure)
-{
-    if (!structure)
-        return false;
-    if (config.excluded_structure_blueprints.empty())
-        return false;
-
-    auto* cls = structure->ClassField();
-    if (!cls)
-        return false;
-    if (!cls->IsValidLowLevelFast(true))
-        return false;
-
-    FString path;
-    if (!TryGetPathNameSafe(cls, &path))
-        return false;
-    const auto normalized = NormalizeBlueprintPath(path.ToString());
-    if (normalized.empty())
-        return false;
-
-    for (const auto& excluded : config.excluded_structure_blueprints)
-    {
-        if (normalized.find(excluded) != std::string::npos)
-            return true;
-    }
-
-    return false;
-}
-
-AShooterPlayerState* GetPlayerState(AShooterPlayerController* pc)
-{
-    if (!pc)
-        return nullptr;
-    return pc->GetShooterPlayerState();
-}
-
-bool IsTribeLeaderOrAdmin(AShooterPlayerController* pc)
-{
-    if (!pc)
-        return false;
+// Asks the game; see IsTribeLeaderOrAdmin for the cached check.
+bool CheckTribeLeaderOrAdmin(AShooterPlayerController* pc)
+{
+    if (!pc)
+        return false;
 
     if (pc->IsTribeAdmin())
         return true;
@@ -1084,6 +868,29 @@ bool IsTribeLeaderOrAdmin(AShooterPlayerController* pc)
     return false;
 }
 
+// CheckTribeLeaderOrAdmin, asked at most once per controller, tribe and timer
+// tick. `tribe_id` is the caller's GetTribeIdFromPlayer(pc); a hit looks up
+// nothing else.
+bool IsTribeLeaderOrAdmin(AShooterPlayerController* pc, int64_t tribe_id)
+{
+    if (!pc)
+        return false;
+
+    switch (player_auth.Find(pc, tribe_id))
+    {
+    case PlayerAuthCache::Verdict::Allowed:
+        return true;
+    case PlayerAuthCache::Verdict::Denied:
+        return false;
+    case PlayerAuthCache::Verdict::Unknown:
+        break;
+    }
+
+    const bool allowed = CheckTribeLeaderOrAdmin(pc);
+    player_auth.Store(pc, tribe_id, allowed);
+    return allowed;
+}
+
 bool IsTribeLeaderOrAdminOnline(int64_t tribe_id)
 {
     if (tribe_id == 0)
@@ -1125,6 +932,61 @@ bool IsTribeLeaderOrAdminOnline(int64_t tribe_id)
     return false;
 }
 
+bool ArkWorld::IsReady()
+{
+    return ArkApi::GetApiUtils().GetStatus() == ArkApi::ServerStatus::Ready &&
+           ArkApi::GetApiUtils().GetShooterGameMode() != nullptr;
+}
+
+bool ArkWorld::AreTribesAllied(int64_t tribe_id, int64_t other_id)
+{
+    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
+    return game_mode && game_mode->AreTribesAllied(static_cast<int>(tribe_id), static_cast<int>(other_id));
+}
+
+bool ArkWorld::IsTribeOnline(int64_t tribe_id)
+{
+    return IsTribeLeaderOrAdminOnline(tribe_id);
+}
+
+int32_t ArkWorld::GetTribeCount()
+{
+    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
+    return game_mode ? game_mode->TribesDataField().Num() : 0;
+}
+
+void ArkWorld::ReadTribeMembers(int32_t begin, int32_t end, std::vector<TribeMembers>& out)
+{
+    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
+    if (!game_mode)
+        return;
+
+    const auto& tribes = game_mode->TribesDataField();
+    end = (std::min)(end, tribes.Num());
+    for (int i = begin; i < end; ++i)
+    {
+        auto& data = const_cast<FTribeData&>(tribes[i]);
+        int32_t tid = 0;
+        const int32_t members = TryGetTribeMemberCount(data, tid);
+        if (tid <= 0 || members < 0)
+            continue;
+        out.push_back(TribeMembers{ CanonicalTribeId(static_cast<int64_t>(tid)), members });
+    }
+}
+
+bool ArkWorld::TryGetClassPath(const void* structure_class, std::string& out_path)
+{
+    auto* cls = static_cast<UClass*>(const_cast<void*>(structure_class));
+    if (!cls || !cls->IsValidLowLevelFast(true))
+        return false;
+
+    FString path;
+    if (!TryGetPathNameSafe(cls, &path))
+        return false;
+    out_path = path.ToString();
+    return true;
+}
+
 void SendPlayerMessage(AShooterPlayerController* pc, const FString& message)
 {
     if (!pc)
@@ -1224,217 +1086,52 @@ FString FormatDuration(int64_t seconds)
     return FString::Format(L"{}ч {}м {}с", hours, minutes, secs);
 }
 
-WarRecord* GetWarForTribeLocked(int64_t tribe_id)
-{
-    auto it = tribe_to_war_id.find(tribe_id);
-    if (it == tribe_to_war_id.end())
-        return nullptr;
-
-    auto war_it = wars_by_id.find(it->second);
-    if (war_it == wars_by_id.end())
-        return nullptr;
-
-    return &war_it->second;
-}
-
-std::optional<WarRecord> GetWarForTribeCopy(int64_t tribe_id)
-{
-    tribe_id = CanonicalTribeId(tribe_id);
-    DataLockGuard lock(data_mutex);
-    if (auto* war = GetWarForTribeLocked(tribe_id))
-    {
-        if (GetPhase(*war, Now()) == WarPhase::None)
-            return std::nullopt;
-        return *war;
-    }
-    return std::nullopt;
-}
-
-struct WarView
-{
-    WarRecord war;
-    int64_t side_root = 0; // war.tribe_a or war.tribe_b that this tribe belongs to (directly or via alliance)
-};
-
-std::optional<WarView> GetWarForSideCopy(int64_t tribe_id)
-{
-    if (tribe_id == 0)
-        return std::nullopt;
-
-    // Fast path: direct participant.
-    if (auto direct = GetWarForTribeCopy(tribe_id))
-    {
-        const auto& war = *direct;
-        const int64_t side_root = (tribe_id == war.tribe_a) ? war.tribe_a : war.tribe_b;
-        return WarView{ war, side_root };
-    }
-
-    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
-    if (!game_mode)
-        return std::nullopt;
-
-    const auto now = Now();
-    DataLockGuard lock(data_mutex);
-    for (const auto& it : wars_by_id)
-    {
-        const auto& war = it.second;
-        if (GetPhase(war, now) == WarPhase::None)
-            continue;
-
-        const bool on_a = (tribe_id == war.tribe_a) ||
-                          game_mode->AreTribesAllied(static_cast<int>(tribe_id), static_cast<int>(war.tribe_a));
-        const bool on_b = (tribe_id == war.tribe_b) ||
-                          game_mode->AreTribesAllied(static_cast<int>(tribe_id), static_cast<int>(war.tribe_b));
-
-        if (on_a == on_b)
-            continue;
-
-        return WarView{ war, on_a ? war.tribe_a : war.tribe_b };
-    }
-
-    return std::nullopt;
-}
-
-bool IsTribeInCooldown(int64_t tribe_id, int64_t now)
-{
-    tribe_id = CanonicalTribeId(tribe_id);
-    DataLockGuard lock(data_mutex);
-    auto* war = GetWarForTribeLocked(tribe_id);
-    if (!war)
-        return false;
-    if (war->ended_at == 0)
-        return false;
-
-    if (GetPhase(*war, now) != WarPhase::Cooldown)
-        return false;
-
-    if (tribe_id == war->tribe_a)
-        return now < war->cooldown_end_a;
-    if (tribe_id == war->tribe_b)
-        return now < war->cooldown_end_b;
-    return false;
-}
-
-void RemoveWarLocked(int64_t war_id, int64_t now)
-{
-    wars_by_id.erase(war_id);
-    RebuildTribeIndexLocked(now);
-}
-
-bool CleanupExpiredWarsLocked(int64_t now)
-{
-    std::vector<int64_t> to_remove;
-    for (const auto& it : wars_by_id)
-    {
-        const auto& war = it.second;
-        if (war.ended_at == 0)
-            continue;
-        if (war.cooldown_end_a <= 0 || war.cooldown_end_b <= 0)
-            continue;
-        if (now >= war.cooldown_end_a && now >= war.cooldown_end_b)
-            to_remove.push_back(it.first);
-    }
-
-    for (const auto war_id : to_remove)
-        RemoveWarLocked(war_id, now);
-
-    return !to_remove.empty();
-}
-
 bool IsWarAllowed(int64_t tribe_a, int64_t tribe_b, int64_t now, FString& reason)
 {
-    tribe_a = CanonicalTribeId(tribe_a);
-    tribe_b = CanonicalTribeId(tribe_b);
-    if (tribe_a == 0 || tribe_b == 0)
+    switch (war_engine.CheckWarAllowed(tribe_a, tribe_b, now))
     {
+    case WarDenyReason::None:
+        return true;
+    case WarDenyReason::NoTribe:
         reason = L"Вы должны состоять в племени.";
-        return false;
-    }
-
-    if (tribe_a == tribe_b)
-    {
+        break;
+    case WarDenyReason::SameTribe:
         reason = L"Нельзя объявить войну своему племени.";
-        return false;
-    }
-
-    if (ArkApi::GetApiUtils().GetStatus() == ArkApi::ServerStatus::Ready)
-    {
-        auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
-        if (game_mode && game_mode->AreTribesAllied(static_cast<int>(tribe_a), static_cast<int>(tribe_b)))
-        {
-            reason = L"Нельзя объявить войну союзному племени. Сначала разорвите альянс.";
-            return false;
-        }
-    }
-
-    if (GetWarForTribeCopy(tribe_a).has_value() || GetWarForTribeCopy(tribe_b).has_value())
-    {
+        break;
+    case WarDenyReason::Allied:
+        reason = L"Нельзя объявить войну союзному племени. Сначала разорвите альянс.";
+        break;
+    case WarDenyReason::AlreadyInWar:
         reason = L"У одного из племён уже есть активная война или откат.";
-        return false;
-    }
-
-    if (!IsTribeLeaderOrAdminOnline(tribe_b))
-    {
+        break;
+    case WarDenyReason::TargetOffline:
         reason = L"Лидер/администратор целевого племени должен быть в сети.";
-        return false;
-    }
-
-    if (IsTribeInCooldown(tribe_a, now) || IsTribeInCooldown(tribe_b, now))
-    {
+        break;
+    case WarDenyReason::Cooldown:
         reason = L"Сейчас действует откат.";
-        return false;
+        break;
     }
-
-    return true;
+    return false;
 }
 
 void DeclareWar(int64_t tribe_a, int64_t tribe_b)
 {
-    tribe_a = CanonicalTribeId(tribe_a);
-    tribe_b = CanonicalTribeId(tribe_b);
-    WarRecord war;
-    {
-        DataLockGuard lock(data_mutex);
-        war.war_id = next_war_id++;
-        war.tribe_a = tribe_a;
-        war.tribe_b = tribe_b;
-        war.declared_at = Now();
-        war.start_at = war.declared_at + config.war_delay_seconds;
-        wars_by_id[war.war_id] = war;
-        RebuildTribeIndexLocked(war.declared_at);
-    }
-    need_save.store(true);
-
-    const FString delay = FormatDuration(config.war_delay_seconds);
-    const FString tribe_a_name = GetTribeDisplayName(tribe_a);
-    const FString tribe_b_name = GetTribeDisplayName(tribe_b);
-    NotifySide(tribe_a, FString::Format(L"Вы объявили войну племени {}. Начало через {}.", *tribe_b_name, *delay));
-    NotifySide(tribe_b, FString::Format(L"Племя {} объявило вам войну. Начало через {}.", *tribe_a_name, *delay));
+    const auto war = war_engine.DeclareWar(tribe_a, tribe_b);
+
+    const FString delay = FormatDuration(Cfg().war_delay_seconds);
+    const FString& tribe_a_name = GetTribeDisplayName(war.tribe_a);
+    const FString& tribe_b_name = GetTribeDisplayName(war.tribe_b);
+    NotifySide(war.tribe_a, FString::Format(L"Вы объявили войну племени {}. Начало через {}.", *tribe_b_name, *delay));
+    NotifySide(war.tribe_b, FString::Format(L"Племя {} объявило вам войну. Начало через {}.", *tribe_a_name, *delay));
     // Logging disabled to avoid crashes in early init
 }
 
 void RequestCancelWar(int64_t tribe_id)
 {
     tribe_id = CanonicalTribeId(tribe_id);
-    int64_t other = 0;
-    int64_t war_id = 0;
-    {
-        DataLockGuard lock(data_mutex);
-        auto* war = GetWarForTribeLocked(tribe_id);
-        if (!war)
-            return;
-        if (war->ended_at != 0)
-            return;
-
-        war_id = war->war_id;
-        if (tribe_id == war->tribe_a)
-            war->cancel_requested_by_a = true;
-        else if (tribe_id == war->tribe_b)
-            war->cancel_requested_by_b = true;
-
-        other = tribe_id == war->tribe_a ? war->tribe_b : war->tribe_a;
-    }
-    need_save.store(true);
+    const int64_t other = war_engine.RequestCancelWar(tribe_id);
+    if (other == 0)
+        return;
     NotifySide(other, L"Противник запросил отмену войны. Чтобы подтвердить, введите /accept.");
     NotifySide(tribe_id, L"Запрос на отмену войны отправлен. Ожидайте подтверждения /accept от противника.");
     // Logging disabled to avoid crashes in early init
@@ -1442,177 +1139,43 @@ void RequestCancelWar(int64_t tribe_id)
 
 void AcceptCancelWar(int64_t tribe_id)
 {
-    tribe_id = CanonicalTribeId(tribe_id);
-    WarRecord snapshot;
-    bool canceled = false;
-
-    {
-        DataLockGuard lock(data_mutex);
-        auto* war = GetWarForTribeLocked(tribe_id);
-        if (!war)
-            return;
-        if (war->ended_at != 0)
-            return;
-
-        if (tribe_id == war->tribe_a)
-            war->cancel_requested_by_a = true;
-        else if (tribe_id == war->tribe_b)
-            war->cancel_requested_by_b = true;
-
-        if (!(war->cancel_requested_by_a && war->cancel_requested_by_b))
-            return;
-
-        const auto now = Now();
-        war->ended_at = now;
-        war->cooldown_end_a = now + config.cooldown_seconds;
-        war->cooldown_end_b = now + config.cooldown_seconds;
-        war->cancel_requested_by_a = false;
-        war->cancel_requested_by_b = false;
-        war->cooldown_notified = false;
-        snapshot = *war;
-        canceled = true;
-        RebuildTribeIndexLocked(now);
-    }
-    need_save.store(true);
-
-    if (!canceled)
+    const auto snapshot = war_engine.AcceptCancelWar(tribe_id);
+    if (!snapshot)
         return;
 
-    const FString cooldown = FormatDuration(config.cooldown_seconds);
+    const FString cooldown = FormatDuration(Cfg().cooldown_seconds);
     const FString msg = FString::Format(L"Война отменена. Начался откат ({}).", *cooldown);
-    NotifySideStyled(snapshot.tribe_a, msg, FLinearColor(0.2f, 1.0f, 0.2f, 1.0f), 1.4f, 8.0f);
-    NotifySideStyled(snapshot.tribe_b, msg, FLinearColor(0.2f, 1.0f, 0.2f, 1.0f), 1.4f, 8.0f);
+    NotifySideStyled(snapshot->tribe_a, msg, FLinearColor(0.2f, 1.0f, 0.2f, 1.0f), 1.4f, 8.0f);
+    NotifySideStyled(snapshot->tribe_b, msg, FLinearColor(0.2f, 1.0f, 0.2f, 1.0f), 1.4f, 8.0f);
     // Logging disabled to avoid crashes in early init
 }
 
-bool HasIncomingCancel(int64_t tribe_id)
-{
-    tribe_id = CanonicalTribeId(tribe_id);
-    DataLockGuard lock(data_mutex);
-    auto* war = GetWarForTribeLocked(tribe_id);
-    if (!war)
-        return false;
-
-    if (tribe_id == war->tribe_a)
-        return war->cancel_requested_by_b;
-    if (tribe_id == war->tribe_b)
-        return war->cancel_requested_by_a;
-    return false;
-}
-
 std::vector<PendingNotification> ProcessTimers()
 {
     std::vector<PendingNotification> notifications_out;
-    
-    if (!auto_timers_enabled)
-        return notifications_out;
 
     if (!plugin_initialized)
         return notifications_out;
 
-    try
+    for (const auto& event : war_engine.ProcessTimers(Now()))
     {
-        const auto now = Now();
-        bool changed = false;
+        if (event.type == WarEventType::Started)
         {
-            DataLockGuard lock(data_mutex);
-            if (wars_by_id.empty())
-                return notifications_out;
-
-            // IMPORTANT: never erase from unordered_map while iterating it.
-            // Collect IDs to remove first, then erase after the loop.
-            std::vector<int64_t> war_ids_to_remove;
-
-            for (auto& it : wars_by_id)
-            {
-                auto& war = it.second;
-                if (war.war_id == 0 || war.tribe_a == 0 || war.tribe_b == 0)
-                    continue;
-                if (war.start_at == 0 && war.declared_at != 0)
-                    war.start_at = war.declared_at + config.war_delay_seconds;
-                if (war.start_at == 0)
-                    war.start_at = now + config.war_delay_seconds;
-                if (war.ended_at == 0 && now >= war.start_at && !war.start_notified)
-                {
-                    PendingNotification n;
-                    n.styled = true;
-                    n.color = FLinearColor(1.0f, 0.15f, 0.15f, 1.0f);
-                    n.scale = 2.2f;
-                    n.time = 12.0f;
-                    n.message = FString(L"Война началась!");
-
-                    n.side_tribe_id = war.tribe_a;
-                    notifications_out.push_back(n);
-                    n.side_tribe_id = war.tribe_b;
-                    notifications_out.push_back(n);
-                    war.start_notified = true;
-                    changed = true;
-
-                    if (config.self_test)
-                        AppendSelfTestLog("ProcessTimers: war started war_id=" + std::to_string(war.war_id));
-                }
-
-                // Self-test: keep war Active for N seconds, then end and start cooldown.
-                if (config.self_test && war.ended_at == 0 && war.start_notified)
-                {
-                    const auto active_seconds = std::max<int32_t>(1, config.self_test_active_seconds);
-                    if (now >= war.start_at + active_seconds)
-                    {
-                        war.ended_at = now;
-                        war.cooldown_end_a = now + config.cooldown_seconds;
-                        war.cooldown_end_b = now + config.cooldown_seconds;
-                        war.cooldown_notified = false;
-                        changed = true;
-                        AppendSelfTestLog("ProcessTimers: war ended war_id=" + std::to_string(war.war_id) +
-                                          " cooldown=" + std::to_string(config.cooldown_seconds) + "s");
-                    }
-                }
-
-                if (war.ended_at != 0)
-                {
-                    if (!war.cooldown_notified && now >= war.cooldown_end_a && now >= war.cooldown_end_b)
-                    {
-                        notifications_out.push_back(PendingNotification{ war.tribe_a, FString(L"Откат закончился.") });
-                        notifications_out.push_back(PendingNotification{ war.tribe_b, FString(L"Откат закончился.") });
-                        war.cooldown_notified = true;
-                        changed = true;
-
-                        if (config.self_test)
-                            AppendSelfTestLog("ProcessTimers: cooldown ended war_id=" + std::to_string(war.war_id));
-                    }
-
-                    // War can be cleaned up after both cooldowns ended.
-                    if (war.cooldown_end_a > 0 && war.cooldown_end_b > 0 &&
-                        now >= war.cooldown_end_a && now >= war.cooldown_end_b)
-                    {
-                        war_ids_to_remove.push_back(it.first);
-                    }
-                }
-            }
-
-            if (!war_ids_to_remove.empty())
-            {
-                for (const auto war_id : war_ids_to_remove)
-                    wars_by_id.erase(war_id);
-
-                RebuildTribeIndexLocked(now);
-                changed = true;
-
-                if (config.self_test)
-                {
-                    AppendSelfTestLog("ProcessTimers: cleaned up wars count=" + std::to_string(war_ids_to_remove.size()));
-                }
-            }
+            PendingNotification n;
+            n.side_tribe_id = event.side_tribe_id;
+            n.styled = true;
+            n.color = FLinearColor(1.0f, 0.15f, 0.15f, 1.0f);
+            n.scale = 2.2f;
+            n.time = 12.0f;
+            n.message = FString(L"Война началась!");
+            notifications_out.push_back(n);
+        }
+        else if (event.type == WarEventType::CooldownEnded)
+        {
+            notifications_out.push_back(PendingNotification{ event.side_tribe_id, FString(L"Откат закончился.") });
         }
-
-        if (changed)
-            need_save.store(true);
-    }
-    catch (...)
-    {
-        auto_timers_enabled = false;
     }
-    
+
     return notifications_out;
 }
 
@@ -1624,138 +1187,302 @@ void EnqueueNotifications(const std::vector<PendingNotification>& notes)
     pending_notifications.insert(pending_notifications.end(), notes.begin(), notes.end());
 }
 
-void FlushNotificationQueue()
+// Sends queued notifications until the deadline; the rest stay queued, in order.
+bool FlushNotificationQueue(const StageDeadline& deadline)
 {
     std::vector<PendingNotification> local;
     {
         DataLockGuard lock(notification_mutex);
         if (pending_notifications.empty())
-            return;
+            return true;
         local.swap(pending_notifications);
     }
 
-    for (const auto& note : local)
+    size_t sent = 0;
+    while (sent < local.size())
     {
+        const auto& note = local[sent++];
         if (note.styled)
             NotifySideStyled(note.side_tribe_id, note.message, note.color, note.scale, note.time);
         else
             NotifySide(note.side_tribe_id, note.message);
+
+        if (sent < local.size() && deadline.Expired())
+            break;
     }
+    if (sent == local.size())
+        return true;
+
+    DataLockGuard lock(notification_mutex);
+    pending_notifications.insert(pending_notifications.begin(), std::make_move_iterator(local.begin() + static_cast<std::ptrdiff_t>(sent)),
+                                 std::make_move_iterator(local.end()));
+    return false;
 }
 
-void TimerCallback()
+// Hot-path stats, plus the lock profile in TRIBEWAR_LOCK_PROFILE builds.
+std::string StatsReport()
 {
-    if (!plugin_initialized)
+    return FormatStats(CollectStats()) + FormatLockProfiles(CollectLockProfiles());
+}
+
+void WriteStatsFile(const std::string& path, int64_t now)
+{
+    try
+    {
+        TraceScope trace("WriteStatsFile", "io");
+        std::ofstream f(path, std::ios::trunc);
+        if (!f.is_open())
+            return;
+        f << "time " << now << "\n" << StatsReport();
+    }
+    catch (...)
+    {
+    }
+}
+
+void MaybeWriteStatsFile()
+{
+    static int64_t last_write = 0;
+    if (Cfg().stats_file_interval_seconds <= 0)
+        return;
+    const auto now = Now();
+    if (now - last_write < Cfg().stats_file_interval_seconds)
         return;
+    last_write = now;
+    io_worker.Post([path = GetStatsPath(), now]() { WriteStatsFile(path, now); });
+}
 
-    UpdateTribeNameCache();
-    UpdateAbandonedTribes(Now());
+// === Config reload ===
+// config.json is read and validated on io_worker; the next timer tick swaps
+// the result in on the game thread. A file that fails to parse is not applied.
+// Every outcome goes to the ArkApi log, and TribeWar.Reload status repeats the
+// last one for RCON, which cannot be answered once the tick has run.
 
-    auto notifications = ProcessTimers();
-    EnqueueNotifications(notifications);
+struct ConfigReloadResult
+{
+    std::shared_ptr<const ConfigSnapshot> snapshot; // null = keep the current config
+    std::string report;
+    uint64_t requester = 0; // SteamID to tell, 0 = RCON or file poll
+    uint64_t request = 0;   // RequestConfigReload sequence number, 0 = file poll
+};
 
-    if (ArkApi::GetApiUtils().GetStatus() == ArkApi::ServerStatus::Ready)
-        FlushNotificationQueue();
+WinMutex config_reload_mutex{ "config_reload_mutex" };
+std::optional<ConfigReloadResult> config_reload_result; // guarded by config_reload_mutex, newest wins
+std::filesystem::file_time_type config_file_time;       // io_worker only
 
-    FlushSaveIfNeeded();
-    SaveTribeNameCache();
-}
+// Game thread only.
+uint64_t config_reload_requests = 0; // RequestConfigReload calls so far
+uint64_t config_reload_answered = 0; // highest request whose result was applied
+int64_t config_reload_applied_at = 0;
+std::string config_reload_report;    // of the last applied result, for TribeWar.Reload status
 
-std::vector<WarRecord> GetActiveWarsSnapshot(int64_t now)
+// io_worker only. True when config.json was written since the last call.
+bool ConfigFileChanged(const std::string& path)
 {
-    std::vector<WarRecord> result;
-    DataLockGuard lock(data_mutex);
-    result.reserve(wars_by_id.size());
-    for (const auto& it : wars_by_id)
-    {
-        const auto& war = it.second;
-        if (IsActiveWar(war, now))
-            result.push_back(war);
-    }
-    return result;
+    std::error_code ec;
+    const auto file_time = std::filesystem::last_write_time(path, ec);
+    if (ec || file_time == config_file_time)
+        return false;
+    config_file_time = file_time;
+    return true;
 }
 
-bool IsStructureDamageAllowed(APrimalStructure* structure, AController* instigator, AActor* causer, float& out_multiplier)
+// io_worker only.
+void ReadConfigForReload(const std::string& path, uint64_t requester, uint64_t request)
 {
-    out_multiplier = 1.0f;
-    if (!structure)
-        return true;
+    ConfigReloadResult result;
+    result.requester = requester;
+    result.request = request;
 
-    if (ArkApi::GetApiUtils().GetStatus() != ArkApi::ServerStatus::Ready)
-        return false;
+    Config loaded;
+    std::string error;
+    if (!LoadConfigFile(path, loaded, &error))
+    {
+        result.report = "Config not reloaded: " + path + " not found";
+    }
+    else if (!error.empty())
+    {
+        result.report = "Config not reloaded: " + error;
+    }
+    else
+    {
+        result.report = "Config reloaded";
+        for (const auto& fix : ValidateConfig(loaded))
+            result.report += "\nfixed " + fix;
+        result.snapshot = std::make_shared<const ConfigSnapshot>(loaded);
+    }
 
-    if (IsExcludedStructure(structure))
-        return true;
+    LockGuard<WinMutex> lock(config_reload_mutex);
+    if (config_reload_result && result.request < config_reload_result->request)
+    {
+        // A poll replaced a command's result before the tick: still answer the command.
+        result.request = config_reload_result->request;
+        result.requester = config_reload_result->requester;
+    }
+    config_reload_result = std::move(result);
+}
 
-    const auto now = Now();
-    const auto target_tribe = CanonicalTribeId(structure->TargetingTeamField());
-    int64_t attacker_tribe = 0;
+void RequestConfigReload(uint64_t requester)
+{
+    const auto request = ++config_reload_requests;
+    io_worker.Post([path = GetConfigPath(), requester, request]() {
+        ConfigFileChanged(path); // a poll should not reload it a second time
+        ReadConfigForReload(path, requester, request);
+    });
+}
 
-    if (instigator)
-        attacker_tribe = GetTribeIdFromActor(instigator);
-    if (attacker_tribe == 0 && causer)
-        attacker_tribe = GetTribeIdFromActor(causer);
+// config_poll_seconds: has io_worker compare the file's modification time.
+void MaybePollConfigFile(int64_t now)
+{
+    static int64_t last_poll = 0;
+    const auto interval = Cfg().config_poll_seconds;
+    if (interval <= 0 || now - last_poll < interval)
+        return;
+    last_poll = now;
+    io_worker.Post([path = GetConfigPath()]() {
+        if (ConfigFileChanged(path))
+            ReadConfigForReload(path, 0, 0);
+    });
+}
 
-    if (target_tribe == 0 || attacker_tribe == 0)
+AShooterPlayerController* FindOnlinePlayer(uint64_t player_key)
+{
+    auto* world = ArkApi::GetApiUtils().GetWorld();
+    if (!world || player_key == 0)
+        return nullptr;
+    for (TWeakObjectPtr<APlayerController>& player : world->PlayerControllerListField())
     {
-        // If attacker has no tribe, only allow against abandoned tribes (optional feature).
-        if (target_tribe != 0)
-        {
-            float abandoned_mult = 1.0f;
-            if (IsAbandonedStructureVulnerable(target_tribe, now, abandoned_mult))
-            {
-                out_multiplier = abandoned_mult;
-                return true;
-            }
-        }
-        return false;
+        auto* pc = static_cast<AShooterPlayerController*>(player.Get());
+        if (pc && GetPlayerKey(pc) == player_key)
+            return pc;
     }
+    return nullptr;
+}
 
-    if (target_tribe == attacker_tribe)
-        return true;
+void ApplyPendingConfigReload()
+{
+    std::optional<ConfigReloadResult> result;
+    {
+        LockGuard<WinMutex> lock(config_reload_mutex);
+        result.swap(config_reload_result);
+    }
+    if (!result)
+        return;
 
-    // Abandoned tribe window: structures can be damaged by anyone.
-    float abandoned_mult = 1.0f;
-    if (IsAbandonedStructureVulnerable(target_tribe, now, abandoned_mult))
+    if (result->snapshot)
     {
-        out_multiplier = abandoned_mult;
-        return true;
+        ApplyConfig(std::move(result->snapshot));
+        Log::GetLog()->info("TribeWarSystem: {}", result->report);
+    }
+    else
+    {
+        Log::GetLog()->error("TribeWarSystem: {}", result->report);
     }
+    TRIBEWAR_LOG_INFO(self_test_log, result->report);
+    if (auto* pc = FindOnlinePlayer(result->requester))
+        SendPlayerMessage(pc, FString(result->report.c_str()));
 
-    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
-    if (!game_mode)
-        return false;
+    config_reload_answered = (std::max)(config_reload_answered, result->request);
+    config_reload_applied_at = Now();
+    config_reload_report = std::move(result->report);
+}
 
-    const auto IsAlliedWith = [&](int64_t tribe_id, int64_t other_id) -> bool {
-        if (tribe_id == 0 || other_id == 0)
-            return false;
-        return game_mode->AreTribesAllied(static_cast<int>(tribe_id), static_cast<int>(other_id));
-    };
+std::string ConfigReloadStatus()
+{
+    std::string status;
+    if (config_reload_answered < config_reload_requests)
+        status = "Config reload pending\n";
+    if (config_reload_applied_at == 0)
+        return status + "No config reload since the plugin loaded";
+    return status + "Last config reload " + std::to_string(Now() - config_reload_applied_at) + " s ago: " + config_reload_report;
+}
 
-    const auto IsOnSide = [&](int64_t tribe_id, int64_t side_tribe) -> bool {
-        if (tribe_id == side_tribe)
+// TimerCallback's work, in order. The name cache walk and the notification
+// flush resume where they stopped; the abandoned scan is already one batch per
+// tick; the rest run whole and only report overruns.
+void SetupTimerStages()
+{
+    timer_stages.Add(Stat::TimerNameCache, [](const StageDeadline& deadline) { return UpdateTribeNameCache(deadline); });
+    timer_stages.Add(Stat::TimerAbandonedScan, [](const StageDeadline&) {
+        war_engine.UpdateAbandonedTribes(Now());
+        return true;
+    });
+    timer_stages.Add(Stat::TimerProcessTimers, [](const StageDeadline&) {
+        EnqueueNotifications(ProcessTimers());
+        return true;
+    });
+    timer_stages.Add(Stat::TimerNotifications, [](const StageDeadline& deadline) {
+        if (ArkApi::GetApiUtils().GetStatus() != ArkApi::ServerStatus::Ready)
             return true;
-        return IsAlliedWith(tribe_id, side_tribe);
-    };
-
-    const auto active_wars = GetActiveWarsSnapshot(now);
-    for (const auto& war : active_wars)
-    {
-        const bool attacker_side_a = IsOnSide(attacker_tribe, war.tribe_a);
-        const bool attacker_side_b = IsOnSide(attacker_tribe, war.tribe_b);
-        const bool target_side_a = IsOnSide(target_tribe, war.tribe_a);
-        const bool target_side_b = IsOnSide(target_tribe, war.tribe_b);
-
-        if ((attacker_side_a && target_side_b) || (attacker_side_b && target_side_a))
+        return FlushNotificationQueue(deadline);
+    });
+    timer_stages.Add(Stat::TimerSave, [](const StageDeadline&) {
+        FlushSaveIfNeeded();
+        return true;
+    });
+    timer_stages.Add(Stat::TimerNameCacheSave, [](const StageDeadline&) {
+        SaveTribeNameCache();
+        return true;
+    });
+    timer_stages.Add(Stat::TimerMenuSessions, [](const StageDeadline&) {
+        const auto now = Now();
+        menu_sessions.EvictExpired(now);
+        menu_sessions.CompactFilter();
+        for (auto it = multiuse_menu_cache.begin(); it != multiuse_menu_cache.end();)
         {
-            out_multiplier = config.structure_damage_multiplier;
-            // Log::GetLog()->debug("[TribeWarSystem] Structure damage ALLOWED: War #{}, Attacker tribe {} vs Target tribe {}", war.war_id, attacker_tribe, target_tribe);
-            return true;
+            if (now - it->second.built_at >= kMultiUseMenuCacheSeconds)
+                it = multiuse_menu_cache.erase(it);
+            else
+                ++it;
         }
-    }
+        return true;
+    });
+    timer_stages.Add(Stat::TimerConfigReload, [](const StageDeadline&) {
+        MaybePollConfigFile(Now());
+        ApplyPendingConfigReload();
+        return true;
+    });
+}
 
-    // Log::GetLog()->debug("[TribeWarSystem] Structure damage BLOCKED: Attacker tribe {} vs Target tribe {} (no active war)", attacker_tribe, target_tribe);
-    return false;
+// Ends the running capture and writes it on io_worker. Returns the file path.
+std::string FinishTrace()
+{
+    const auto generation = StopTrace();
+    trace_stop_at = 0;
+    auto path = GetPluginDir() + "/trace_" + std::to_string(Now()) + ".json";
+    io_worker.Post([path, generation]() { WriteTrace(path, generation); });
+    return path;
+}
+
+void TimerCallback()
+{
+    if (!plugin_initialized)
+        return;
+
+    StatScope stat(Stat::Timer);
+    war_engine.BeginTick();
+    player_auth.NextGeneration();
+    timer_stages.RunTick(Cfg().timer_stage_budget_us);
+    MaybeWriteStatsFile();
+    if (trace_stop_at != 0 && Now() >= trace_stop_at)
+        FinishTrace();
+}
+
+bool IsStructureDamageAllowed(APrimalStructure* structure, AController* instigator, AActor* causer, float& out_multiplier)
+{
+    out_multiplier = 1.0f;
+    if (!structure)
+        return true;
+
+    const auto target_tribe = CanonicalTribeId(structure->TargetingTeamField());
+    int64_t attacker_tribe = 0;
+
+    if (instigator)
+        attacker_tribe = GetTribeIdFromActor(instigator);
+    if (attacker_tribe == 0 && causer)
+        attacker_tribe = GetTribeIdFromActor(causer);
+
+    return war_engine.IsStructureDamageAllowed(structure->ClassField(), target_tribe, attacker_tribe, out_multiplier);
 }
 
 FString GetStatusText(const WarRecord* war, int64_t tribe_id)
@@ -1788,14 +1515,8 @@ FString GetStatusText(const WarRecord* war, int64_t tribe_id)
     return FString(L"Войны нет.");
 }
 
-uint64_t GetPlayerKey(AShooterPlayerController* pc)
-{
-    if (!pc)
-        return 0;
-    return ArkApi::IApiUtils::GetSteamIdFromController(pc);
-}
-
-void HandleMenuAction(AShooterPlayerController* pc, int entry_id)
+// Runs a picked menu action for the player's tribe.
+void RunMenuAction(AShooterPlayerController* pc, MenuAction action, int64_t target_id)
 {
     if (!pc)
         return;
@@ -1803,125 +1524,74 @@ void HandleMenuAction(AShooterPlayerController* pc, int entry_id)
     const auto tribe_id = GetTribeIdFromPlayer(pc);
     if (tribe_id == 0)
         return;
-    if (config.multiuse_require_leader && !IsTribeLeaderOrAdmin(pc))
+    if (Cfg().multiuse_require_leader && !IsTribeLeaderOrAdmin(pc, tribe_id))
         return;
 
-    const auto now = Now();
-    const auto player_key = GetPlayerKey(pc);
-
-    // Check radial menu constants first (backward compat)
-    if (entry_id == kMenuStatusId || entry_id == kMuStatusId)
+    switch (action)
     {
-        const auto war_view = GetWarForSideCopy(tribe_id);
+    case MenuAction::Status:
+    {
+        const auto war_view = war_engine.GetWarForSide(tribe_id);
         const int64_t side_root = war_view ? war_view->side_root : tribe_id;
         SendPlayerMessage(pc, GetStatusText(war_view ? &war_view->war : nullptr, side_root));
-        return;
+        break;
     }
-
-    if (entry_id == kMenuCancelId || entry_id == kMuCancelId)
-    {
-        if (!GetWarForTribeCopy(tribe_id).has_value())
+    case MenuAction::Cancel:
+        if (!war_engine.GetWarForTribe(tribe_id).has_value())
         {
             SendPlayerMessage(pc, L"Нет активной войны.");
             return;
         }
         RequestCancelWar(tribe_id);
-        return;
-    }
-
-    if (entry_id == kMenuAcceptCancelId || entry_id == kMuAcceptCancelId)
-    {
-        if (!GetWarForTribeCopy(tribe_id).has_value())
+        break;
+    case MenuAction::AcceptCancel:
+        if (!war_engine.GetWarForTribe(tribe_id).has_value())
         {
             SendPlayerMessage(pc, L"Нет активной войны.");
             return;
         }
-        if (!HasIncomingCancel(tribe_id))
+        if (!war_engine.HasIncomingCancel(tribe_id))
         {
             SendPlayerMessage(pc, L"Нет запроса на отмену.");
             return;
         }
         AcceptCancelWar(tribe_id);
-        return;
-    }
-
-    const bool is_radial_declare = (entry_id >= kMenuDeclareListBaseId && entry_id < kMenuDeclareListBaseId + kMenuDeclareListMax);
-    if (is_radial_declare)
+        break;
+    case MenuAction::Declare:
     {
-        auto target_it = declare_targets.find(player_key);
-        if (target_it == declare_targets.end())
-            return;
-        auto entry_it = target_it->second.find(entry_id);
-        if (entry_it == target_it->second.end())
-            return;
-        const auto target_id = entry_it->second;
         FString reason;
-        if (!IsWarAllowed(tribe_id, target_id, now, reason))
+        if (!IsWarAllowed(tribe_id, target_id, Now(), reason))
         {
             SendPlayerMessage(pc, reason);
             return;
         }
         DeclareWar(tribe_id, target_id);
-        return;
+        break;
+    }
+    case MenuAction::None:
+        break;
     }
+}
 
-    // Dynamic MultiUse: lookup action from multiuse_action_map
-    if (player_key == 0)
-        return;
-    auto action_it = multiuse_action_map.find(player_key);
-    if (action_it == multiuse_action_map.end())
-        return;
-    auto action_entry = action_it->second.find(entry_id);
-    if (action_entry == action_it->second.end())
+void HandleMenuAction(AShooterPlayerController* pc, int entry_id)
+{
+    if (!pc)
         return;
 
-    const int action = action_entry->second;
-    if (action == 1) // status
-    {
-        const auto war_view = GetWarForSideCopy(tribe_id);
-        const int64_t side_root = war_view ? war_view->side_root : tribe_id;
-        SendPlayerMessage(pc, GetStatusText(war_view ? &war_view->war : nullptr, side_root));
-    }
-    else if (action == 2) // cancel
-    {
-        if (!GetWarForTribeCopy(tribe_id).has_value())
-        {
-            SendPlayerMessage(pc, L"Нет активной войны.");
-            return;
-        }
-        RequestCancelWar(tribe_id);
-    }
-    else if (action == 3) // accept_cancel
-    {
-        if (!GetWarForTribeCopy(tribe_id).has_value())
-        {
-            SendPlayerMessage(pc, L"Нет активной войны.");
-            return;
-        }
-        if (!HasIncomingCancel(tribe_id))
-        {
-            SendPlayerMessage(pc, L"Нет запроса на отмену.");
-            return;
-        }
-        AcceptCancelWar(tribe_id);
-    }
-    else if (action >= 100) // declare target
-    {
-        auto target_it = declare_targets.find(player_key);
-        if (target_it == declare_targets.end())
-            return;
-        auto entry_it = target_it->second.find(entry_id);
-        if (entry_it == target_it->second.end())
-            return;
-        const auto target_id = entry_it->second;
-        FString reason;
-        if (!IsWarAllowed(tribe_id, target_id, now, reason))
-        {
-            SendPlayerMessage(pc, reason);
-            return;
-        }
-        DeclareWar(tribe_id, target_id);
-    }
+    // Check radial menu constants first (backward compat)
+    if (entry_id == kMenuStatusId || entry_id == kMuStatusId)
+        return RunMenuAction(pc, MenuAction::Status, 0);
+    if (entry_id == kMenuCancelId || entry_id == kMuCancelId)
+        return RunMenuAction(pc, MenuAction::Cancel, 0);
+    if (entry_id == kMenuAcceptCancelId || entry_id == kMuAcceptCancelId)
+        return RunMenuAction(pc, MenuAction::AcceptCancel, 0);
+
+    // Everything else was handed out by the last menu this player opened.
+    const auto player_key = GetPlayerKey(pc);
+    if (player_key == 0)
+        return;
+    if (const auto* entry = menu_sessions.Find(player_key, entry_id, Now()))
+        RunMenuAction(pc, entry->action, entry->target_tribe_id);
 }
 
 #if TRIBEWAR_ENABLE_RADIAL
@@ -1930,7 +1600,8 @@ void BuildTribeWarMenu(AShooterPlayerController* pc, TArray<FTribeRadialMenuEntr
     if (!pc || !entries)
         return;
 
-    if (GetTribeIdFromPlayer(pc) == 0 || !IsTribeLeaderOrAdmin(pc))
+    const auto tribe_id = GetTribeIdFromPlayer(pc);
+    if (tribe_id == 0 || !IsTribeLeaderOrAdmin(pc, tribe_id))
         return;
 
     FTribeRadialMenuEntry root;
@@ -1963,7 +1634,7 @@ void BuildTribeWarMenu(AShooterPlayerController* pc, TArray<FTribeRadialMenuEntr
     cancel.ParentID = kMenuRootId;
     entries->Add(cancel);
 
-    if (HasIncomingCancel(GetTribeIdFromPlayer(pc)))
+    if (war_engine.HasIncomingCancel(GetTribeIdFromPlayer(pc)))
     {
         FTribeRadialMenuEntry accept;
         accept.EntryName = FString(L"Принять отмену");
@@ -1980,53 +1651,33 @@ void BuildDeclareListMenu(AShooterPlayerController* pc, TArray<FTribeRadialMenuE
         return;
 
     const auto tribe_id = GetTribeIdFromPlayer(pc);
-    if (tribe_id == 0 || !IsTribeLeaderOrAdmin(pc))
+    if (tribe_id == 0 || !IsTribeLeaderOrAdmin(pc, tribe_id))
         return;
 
-    const auto now = Now();
-    if (GetWarForTribeCopy(tribe_id).has_value() || IsTribeInCooldown(tribe_id, now))
+    const auto& targets = GetDeclareTargets(Now());
+    if (targets.IsBusy(tribe_id))
         return;
 
     int list_count = 0;
     const auto player_key = GetPlayerKey(pc);
     if (player_key == 0)
         return;
-    declare_targets[player_key].clear();
-    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
-    if (!game_mode)
-        return;
-    const auto& tribes = game_mode->TribesDataField();
-    std::unordered_set<int64_t> seen_ids;
-    for (int i = 0; i < tribes.Num(); ++i)
+    auto& session = menu_sessions.Begin(player_key, pc, Now());
+    for (const auto& target : targets.targets)
     {
-        auto& data = const_cast<FTribeData&>(tribes[i]);
-        if (list_count >= kMenuDeclareListMax)
-            break;
-        int32_t tid = 0;
-        const int32_t members = TryGetTribeMemberCount(data, tid);
-        if (members <= 0)
-            continue;
-        const int64_t other_id = CanonicalTribeId(static_cast<int64_t>(tid));
-        if (other_id == 0)
-            continue;
-        if (other_id == tribe_id)
-            continue;
-        if (!seen_ids.insert(other_id).second)
-            continue;
-        if (GetWarForTribeCopy(other_id).has_value() || IsTribeInCooldown(other_id, now))
+        if (list_count >= kMenuDeclareListMax)
+            break;
+        if (target.tribe_id == tribe_id)
             continue;
+        if (!session.Add(kMenuDeclareListBaseId + list_count, MenuAction::Declare, target.tribe_id))
+            break;
 
         FTribeRadialMenuEntry item;
-        const FString entry_label = GetTribeDisplayName(other_id);
-        if (!entry_label.IsEmpty())
-            item.EntryName = entry_label;
-        else
-            item.EntryName = FString::Format(L"ID: {}", other_id);
+        item.EntryName = target.display;
         item.EntryDescription = FString(L"Объявить войну");
         item.EntryID = kMenuDeclareListBaseId + list_count;
         item.ParentID = kMenuDeclareId;
         entries->Add(item);
-        declare_targets[player_key][item.EntryID] = other_id;
         ++list_count;
     }
 }
@@ -2034,112 +1685,78 @@ void BuildDeclareListMenu(AShooterPlayerController* pc, TArray<FTribeRadialMenuE
 
 // === MultiUse wheel integration (server-side radial) ===
 
-static void DumpMultiUseEntries(const char* prefix, const TArray<FMultiUseEntry>* entries)
+static void DumpMultiUseEntries(const char* hook_name, const char* stage, const TArray<FMultiUseEntry>* entries)
 {
-    if (!config.debug_multiuse_log)
+    if (!multiuse_log.Wants())
         return;
     if (!entries)
         return;
 
     const int count = entries->Num();
-    AppendMultiUseDebugLog(std::string(prefix) + ": count=" + std::to_string(count));
+    TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: {} count={}", hook_name, stage, count);
 
     const int limit = (std::min)(count, 40);
     for (int i = 0; i < limit; ++i)
     {
         const auto& e = (*entries)[i];
-        AppendMultiUseDebugLog(
-            std::string(prefix) + " [" + std::to_string(i) + "]" +
-            " idx=" + std::to_string(e.UseIndex) +
-            " prio=" + std::to_string(e.Priority) +
-            " cat=" + std::to_string(e.WheelCategory) +
-            " hideUI=" + std::to_string(static_cast<int>(e.bHideFromUI)) +
-            " disable=" + std::to_string(static_cast<int>(e.bDisableUse)) +
-            " inv=" + std::to_string(static_cast<int>(e.bDisplayOnInventoryUI)) +
-            " inv2=" + std::to_string(static_cast<int>(e.bDisplayOnInventoryUISecondary)) +
-            " inv3=" + std::to_string(static_cast<int>(e.bDisplayOnInventoryUITertiary)) +
-            " sec=" + std::to_string(static_cast<int>(e.bIsSecondaryUse)) +
-            " clientOnly=" + std::to_string(static_cast<int>(e.bClientSideOnly)));
+        TRIBEWAR_LOGF_DEBUG(multiuse_log,
+            "{}: {} [{}] idx={} prio={} cat={} hideUI={} disable={} inv={} inv2={} inv3={} sec={} clientOnly={}",
+            hook_name, stage, i, e.UseIndex, e.Priority, e.WheelCategory,
+            static_cast<int>(e.bHideFromUI), static_cast<int>(e.bDisableUse), static_cast<int>(e.bDisplayOnInventoryUI),
+            static_cast<int>(e.bDisplayOnInventoryUISecondary), static_cast<int>(e.bDisplayOnInventoryUITertiary),
+            static_cast<int>(e.bIsSecondaryUse), static_cast<int>(e.bClientSideOnly));
     }
 
     if (count > limit)
-        AppendMultiUseDebugLog(std::string(prefix) + ": (truncated, total=" + std::to_string(count) + ")");
+        TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: {} (truncated, total={})", hook_name, stage, count);
 }
 
-static void AddMultiUseEntry(TArray<FMultiUseEntry>* entries, int use_index, const FString& text, int priority = 0)
+// Status/Cancel/Accept, built on first use (FString needs the game runtime).
+struct MultiUseTemplates
 {
-    if (!entries)
-        return;
-    FMultiUseEntry e;
-    memset(&e, 0, sizeof(e));
-    e.ForComponent = nullptr; // CRITICAL: must be valid pointer or nullptr
-    e.UseString = text;
-    e.UseIndex = use_index;
-    e.Priority = priority;
-    e.bHideFromUI = 0;
-    e.bDisableUse = 0;
-    e.WheelCategory = 0;
-    e.DisableUseColor = FColor(0, 0, 0, 0);
-    e.UseTextColor = FColor(255, 255, 255, 255);
-    e.EntryActivationTimer = 0.0f;
-    e.DefaultEntryActivationTimer = 0.0f;
-    e.ActivationSound = nullptr;
-    e.UseInventoryButtonStyleOverrideIndex = 0;
-    entries->Add(e);
-}
+    FMultiUseEntry status = MakeMultiUseEntry(FString(L"Mega Tribe War: Статус"), 10);
+    FMultiUseEntry cancel = MakeMultiUseEntry(FString(L"Mega Tribe War: Отмена"), 10);
+    FMultiUseEntry accept_cancel = MakeMultiUseEntry(FString(L"Mega Tribe War: Принять отмену"), 10);
+};
 
-static void BuildDeclareListMultiUse(AShooterPlayerController* pc, int64_t tribe_id, TArray<FMultiUseEntry>* entries, int& next_index)
+static const MultiUseTemplates& GetMultiUseTemplates()
 {
-    if (!pc || !entries)
-        return;
+    static const MultiUseTemplates templates;
+    return templates;
+}
 
-    const auto now = Now();
-    if (GetWarForTribeCopy(tribe_id).has_value() || IsTribeInCooldown(tribe_id, now))
-        return;
+static void AddMultiUseEntry(TArray<FMultiUseEntry>* entries, const FMultiUseEntry& entry, int use_index)
+{
+    (*entries)[entries->Add(entry)].UseIndex = use_index;
+}
 
-    const int max_targets = std::min<int>(kMenuDeclareListMax, config.multiuse_max_targets);
-    if (max_targets <= 0)
-        return;
+static int MultiUseDeclareLimit()
+{
+    return std::min<int>(kMenuDeclareListMax, Cfg().multiuse_max_targets);
+}
 
-    const auto player_key = GetPlayerKey(pc);
-    if (player_key == 0)
+static void BuildDeclareListMultiUse(int64_t tribe_id, const DeclareTargetCache& targets, TArray<FMultiUseEntry>* entries,
+                                     MenuSession& session, int& next_index)
+{
+    if (targets.IsBusy(tribe_id))
         return;
-    declare_targets[player_key].clear();
 
-    auto* game_mode = ArkApi::GetApiUtils().GetShooterGameMode();
-    if (!game_mode)
+    const int max_targets = MultiUseDeclareLimit();
+    if (max_targets <= 0)
         return;
-    const auto& tribes = game_mode->TribesDataField();
 
     int list_count = 0;
-    std::unordered_set<int64_t> seen_ids;
-    for (int i = 0; i < tribes.Num(); ++i)
+    for (const auto& target : targets.targets)
     {
         if (list_count >= max_targets)
             break;
-        auto& data = const_cast<FTribeData&>(tribes[i]);
-        int32_t tid = 0;
-        const int32_t members = TryGetTribeMemberCount(data, tid);
-        if (members <= 0)
-            continue;
-        const int64_t other_id = CanonicalTribeId(static_cast<int64_t>(tid));
-        if (other_id == 0)
-            continue;
-        if (other_id == tribe_id)
-            continue;
-        if (!seen_ids.insert(other_id).second)
-            continue;
-        if (GetWarForTribeCopy(other_id).has_value() || IsTribeInCooldown(other_id, now))
+        if (target.tribe_id == tribe_id)
             continue;
 
         const int entry_id = next_index++;
-        const FString display_name = GetTribeDisplayName(other_id);
-        const auto label = display_name.IsEmpty()
-            ? FString::Format(L"Объявить войну: ID {}", other_id)
-            : FString::Format(L"Объявить войну: {}", *display_name);
-        AddMultiUseEntry(entries, entry_id, label);
-        declare_targets[player_key][entry_id] = other_id;
-        multiuse_action_map[player_key][entry_id] = 100 + list_count; // action=declare target #N
+        if (!session.Add(entry_id, MenuAction::Declare, target.tribe_id))
+            break;
+        AddMultiUseEntry(entries, target.multiuse_entry, entry_id);
         ++list_count;
     }
 }
@@ -2152,7 +1769,7 @@ static void MaybeAddMultiUseMenu(APrimalStructure* structure, APlayerController*
 {
     if (!plugin_initialized)
         return;
-    if (!config.enable_multiuse_menu)
+    if (!Cfg().enable_multiuse_menu)
         return;
     if (!structure || !for_pc || !entries)
         return;
@@ -2164,35 +1781,32 @@ static void MaybeAddMultiUseMenu(APrimalStructure* structure, APlayerController*
     const auto tribe_id = GetTribeIdFromPlayer(pc);
     if (tribe_id == 0)
     {
-        AppendMultiUseDebugLog(std::string(hook_name) + ": skip (tribe_id=0)");
+        TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: skip (tribe_id=0)", hook_name);
         return;
     }
 
-    const bool is_leader = IsTribeLeaderOrAdmin(pc);
-    if (config.multiuse_require_leader && !is_leader)
+    const auto player_key = GetPlayerKey(pc);
+    const bool is_leader = IsTribeLeaderOrAdmin(pc, tribe_id);
+    if (Cfg().multiuse_require_leader && !is_leader)
     {
-        AppendMultiUseDebugLog(std::string(hook_name) + ": skip (not leader/admin) tribe_id=" + std::to_string(tribe_id));
+        TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: skip (not leader/admin) tribe_id={}", hook_name, tribe_id);
         return;
     }
 
-    const bool owned_ok = !config.multiuse_require_owned_structure || structure->IsOfTribe(static_cast<int>(tribe_id));
+    const bool owned_ok = !Cfg().multiuse_require_owned_structure || structure->IsOfTribe(static_cast<int>(tribe_id));
     if (!owned_ok)
     {
-        AppendMultiUseDebugLog(std::string(hook_name) + ": skip (not owned structure) tribe_id=" + std::to_string(tribe_id));
+        TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: skip (not owned structure) tribe_id={}", hook_name, tribe_id);
         return;
     }
 
     const int before = entries->Num();
 
-    DumpMultiUseEntries((std::string(hook_name) + ": before").c_str(), entries);
+    DumpMultiUseEntries(hook_name, "before", entries);
 
-    const auto player_key = GetPlayerKey(pc);
     if (player_key == 0)
         return;
 
-    // Clear previous mappings for this player
-    multiuse_action_map[player_key].clear();
-
     // Find max UseIndex in existing entries to avoid conflicts
     int max_index = 0;
     for (int i = 0; i < before; ++i)
@@ -2202,85 +1816,139 @@ static void MaybeAddMultiUseMenu(APrimalStructure* structure, APlayerController*
             max_index = idx;
     }
     // Start adding from max+1 (or minimum 100 if no entries exist)
-    int next_index = (std::max)(max_index + 1, 100);
+    const int first_index = (std::max)(max_index + 1, 100);
+    int next_index = first_index;
+
+    const auto now = Now();
+    const auto& targets = GetDeclareTargets(now);
+
+    // Same wheel asked for again: hand back what the player already sees.
+    // The war-state version in the targets stamp covers Cancel/Accept too.
+    auto& cached = multiuse_menu_cache[player_key];
+    if (cached.structure == structure && cached.tribe_id == tribe_id && cached.first_index == first_index &&
+        now - cached.built_at < kMultiUseMenuCacheSeconds && cached.war_version == targets.war_version &&
+        cached.roster_version == targets.roster_version && cached.name_version == targets.name_version &&
+        cached.targets_valid_until == targets.valid_until &&
+        cached.session_generation == menu_sessions.Generation(player_key, now))
+    {
+        entries->Reserve(before + static_cast<int>(cached.entries.size()));
+        for (const auto& entry : cached.entries)
+            entries->Add(entry);
+        TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: reused cached entries count={} tribe_id={}", hook_name, cached.entries.size(), tribe_id);
+        return;
+    }
+
+    // Replaces the player's previous menu
+    auto& session = menu_sessions.Begin(player_key, pc, now);
+
+    // Room for Status/Cancel/Accept and the declare list, so the adds below never regrow the array.
+    const int declare_count = (std::min)(MultiUseDeclareLimit(), static_cast<int>(targets.targets.size()));
+    entries->Reserve(before + 3 + (std::max)(declare_count, 0));
+
+    const auto& templates = GetMultiUseTemplates();
 
     // Always add Status (always valid)
     const int status_idx = next_index++;
-    AddMultiUseEntry(entries, status_idx, FString(L"Mega Tribe War: Статус"), 10);
-    multiuse_action_map[player_key][status_idx] = 1; // action=status
+    AddMultiUseEntry(entries, templates.status, status_idx);
+    session.Add(status_idx, MenuAction::Status);
 
     // Cancel and Accept only if war is active
-    const auto war = GetWarForTribeCopy(tribe_id);
+    const auto war = war_engine.GetWarForTribe(tribe_id);
     if (war.has_value())
     {
         const int cancel_idx = next_index++;
-        AddMultiUseEntry(entries, cancel_idx, FString(L"Mega Tribe War: Отмена"), 10);
-        multiuse_action_map[player_key][cancel_idx] = 2; // action=cancel
+        AddMultiUseEntry(entries, templates.cancel, cancel_idx);
+        session.Add(cancel_idx, MenuAction::Cancel);
 
-        if (HasIncomingCancel(tribe_id))
+        if (war_engine.HasIncomingCancel(tribe_id))
         {
             const int accept_idx = next_index++;
-            AddMultiUseEntry(entries, accept_idx, FString(L"Mega Tribe War: Принять отмену"), 10);
-            multiuse_action_map[player_key][accept_idx] = 3; // action=accept_cancel
+            AddMultiUseEntry(entries, templates.accept_cancel, accept_idx);
+            session.Add(accept_idx, MenuAction::AcceptCancel);
         }
     }
 
-    BuildDeclareListMultiUse(pc, tribe_id, entries, next_index);
+    BuildDeclareListMultiUse(tribe_id, targets, entries, session, next_index);
     const int after = entries->Num();
 
-    DumpMultiUseEntries((std::string(hook_name) + ": after").c_str(), entries);
+    cached.structure = structure;
+    cached.tribe_id = tribe_id;
+    cached.first_index = first_index;
+    cached.session_generation = session.generation;
+    cached.war_version = targets.war_version;
+    cached.roster_version = targets.roster_version;
+    cached.name_version = targets.name_version;
+    cached.targets_valid_until = targets.valid_until;
+    cached.built_at = now;
+    cached.entries.clear();
+    cached.entries.reserve(after - before);
+    for (int i = before; i < after; ++i)
+        cached.entries.push_back((*entries)[i]);
 
-    AppendMultiUseDebugLog(std::string(hook_name) + ": added entries before=" + std::to_string(before) + " after=" + std::to_string(after) +
-                           " tribe_id=" + std::to_string(tribe_id) + " leader=" + std::string(is_leader ? "1" : "0") +
-                           " owned_ok=" + std::string(owned_ok ? "1" : "0"));
+    DumpMultiUseEntries(hook_name, "after", entries);
+
+    TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: added entries before={} after={} tribe_id={} leader={} owned_ok={}", hook_name, before,
+                        after, tribe_id, is_leader ? 1 : 0, owned_ok ? 1 : 0);
 }
 
 static bool MaybeHandleMultiUse(APrimalStructure* structure, APlayerController* for_pc, int use_index, const char* hook_name)
 {
     if (!plugin_initialized)
         return false;
-    if (!config.enable_multiuse_menu)
+    if (!Cfg().enable_multiuse_menu)
         return false;
     if (!for_pc)
         return false;
 
-// Check if this use_index belongs to our plugin (via action_map or radial constants)
-    const auto player_key = GetPlayerKey(static_cast<AShooterPlayerController*>(for_pc));
-    const bool is_our_multiuse = (player_key != 0 && multiuse_action_map.count(player_key) && multiuse_action_map[player_key].count(use_index));
+    auto* pc = static_cast<AShooterPlayerController*>(for_pc);
+
+    // Check if this use_index belongs to our plugin (via the player's menu session or radial constants).
+    // Vanilla uses (doors, storage, crafting) leave at the filter, before any SteamID or map lookup.
     const bool is_radial_action = (use_index == kMenuStatusId || use_index == kMenuCancelId || use_index == kMenuAcceptCancelId ||
                                    (use_index >= kMenuDeclareListBaseId && use_index < kMenuDeclareListBaseId + kMenuDeclareListMax));
-    if (!is_our_multiuse && !is_radial_action)
+    if (!is_radial_action && !menu_sessions.MayHandle(pc, use_index))
         return false;
 
-    auto* pc = static_cast<AShooterPlayerController*>(for_pc);
-    if (!pc)
+    const auto player_key = GetPlayerKey(pc);
+    const MenuEntry* session_entry = player_key != 0 ? menu_sessions.Find(player_key, use_index, Now()) : nullptr;
+    if (!session_entry && !is_radial_action)
         return false;
 
     const auto tribe_id = GetTribeIdFromPlayer(pc);
     if (tribe_id == 0)
     {
-        AppendMultiUseDebugLog(std::string(hook_name) + ": deny use_index=" + std::to_string(use_index) + " (tribe_id=0)");
+        TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: deny use_index={} (tribe_id=0)", hook_name, use_index);
         return false;
     }
 
-    const bool is_leader = IsTribeLeaderOrAdmin(pc);
-    if (config.multiuse_require_leader && !is_leader)
+    const bool is_leader = IsTribeLeaderOrAdmin(pc, tribe_id);
+    if (Cfg().multiuse_require_leader && !is_leader)
     {
-        AppendMultiUseDebugLog(std::string(hook_name) + ": deny use_index=" + std::to_string(use_index) + " (not leader/admin) tribe_id=" + std::to_string(tribe_id));
+        TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: deny use_index={} (not leader/admin) tribe_id={}", hook_name, use_index, tribe_id);
         return false;
     }
 
-    if (config.multiuse_require_owned_structure)
+    if (Cfg().multiuse_require_owned_structure)
     {
         if (!structure || !structure->IsOfTribe(static_cast<int>(tribe_id)))
         {
-            AppendMultiUseDebugLog(std::string(hook_name) + ": deny use_index=" + std::to_string(use_index) + " (not owned structure) tribe_id=" + std::to_string(tribe_id));
+            TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: deny use_index={} (not owned structure) tribe_id={}", hook_name, use_index, tribe_id);
             return false;
         }
     }
 
-    AppendMultiUseDebugLog(std::string(hook_name) + ": handle use_index=" + std::to_string(use_index) + " tribe_id=" + std::to_string(tribe_id));
-    HandleMenuAction(pc, use_index);
+    TRIBEWAR_LOGF_DEBUG(multiuse_log, "{}: handle use_index={} tribe_id={}", hook_name, use_index, tribe_id);
+    // The session decides first: wheel indices handed out this menu may
+    // coincide with the fixed radial constants.
+    if (session_entry)
+    {
+        const MenuEntry entry = *session_entry;
+        RunMenuAction(pc, entry.action, entry.target_tribe_id);
+    }
+    else
+    {
+        HandleMenuAction(pc, use_index);
+    }
     return true;
 }
 
@@ -2350,6 +2018,8 @@ void TimerCallback();
 DECLARE_HOOK(AShooterGameMode_Tick, void, AShooterGameMode*, float);
 void Hook_AShooterGameMode_Tick(AShooterGameMode* game_mode, float delta_seconds)
 {
+    game_clock.Refresh();
+    TraceScope frame("GameMode.Tick", "frame");
     AShooterGameMode_Tick_original(game_mode, delta_seconds);
     
     if (!plugin_initialized &&
@@ -2366,7 +2036,12 @@ float Hook_APrimalStructure_TakeDamage(APrimalStructure* structure, float damage
         return APrimalStructure_TakeDamage_original(structure, damage, event, instigator, causer);
 
     float mult = 1.0f;
-    if (!IsStructureDamageAllowed(structure, instigator, causer, mult))
+    bool allowed = false;
+    {
+        StatScope stat(Stat::DamageHook);
+        allowed = IsStructureDamageAllowed(structure, instigator, causer, mult);
+    }
+    if (!allowed)
         return 0.0f;
 
     mult = (std::max)(0.0f, (std::min)(mult, 10.0f));
@@ -2390,313 +2065,545 @@ void Hook_AShooterPlayerController_OnTribeRadialMenuSelection(AShooterPlayerCont
 }
 #endif
 
-// === Chat Commands ===
-#if TRIBEWAR_ENABLE_CHAT_COMMANDS
-
-void CmdWarStatus(AShooterPlayerController* pc, FString*, EChatSendMode::Type)
+// Sends a multi-line report as one chat line per line.
+void SendReportLines(AShooterPlayerController* pc, const std::string& text)
 {
-    if (!pc)
-        return;
-
-    const auto tribe_id = GetTribeIdFromPlayer(pc);
-    if (tribe_id == 0)
+    const FString sender_name(L"Mega Tribe War");
+    size_t begin = 0;
+    while (begin < text.size())
     {
-        SendPlayerMessage(pc, L"Вы должны состоять в племени.");
-        return;
+        auto end = text.find('\n', begin);
+        if (end == std::string::npos)
+            end = text.size();
+        const FString line(text.substr(begin, end - begin).c_str());
+        ArkApi::GetApiUtils().SendChatMessage(pc, sender_name, L"{}", *line);
+        begin = end + 1;
     }
+}
 
-    if (!IsTribeLeaderOrAdmin(pc))
-    {
-        SendPlayerMessage(pc, L"Только лидер/администратор племени может использовать эту команду.");
+// Admin console / RCON: TribeWar.Stats prints the hot-path counters (and lock
+// profile, if built in) and rewrites stats.txt.
+void ConsoleCmdStats(APlayerController* player_controller, FString*, bool)
+{
+    auto* pc = static_cast<AShooterPlayerController*>(player_controller);
+    if (!pc || !pc->bIsAdmin()())
         return;
-    }
 
-    const auto war_view = GetWarForSideCopy(tribe_id);
-    const int64_t side_root = war_view ? war_view->side_root : tribe_id;
-    const FString status = GetStatusText(war_view ? &war_view->war : nullptr, side_root);
-    SendPlayerMessage(pc, status);
+    SendReportLines(pc, StatsReport());
+    io_worker.Post([path = GetStatsPath(), now = Now()]() { WriteStatsFile(path, now); });
 }
 
-void CmdWarDeclare(AShooterPlayerController* pc, FString*, EChatSendMode::Type)
+void RconCmdStats(RCONClientConnection* connection, RCONPacket* packet, UWorld*)
 {
-    if (!pc)
+    if (!connection || !packet)
         return;
+    FString reply(StatsReport().c_str());
+    connection->SendMessageW(packet->Id, 0, &reply);
+    io_worker.Post([path = GetStatsPath(), now = Now()]() { WriteStatsFile(path, now); });
+}
 
-    UpdateTribeNameCache();
+// TribeWar.Trace start [seconds] | stop. A capture runs for 60 seconds unless
+// given a length or stopped early, then is written to trace_<time>.json.
+std::string HandleTraceCommand(const std::string& command_line)
+{
+    std::istringstream in(command_line);
+    std::string command;
+    std::string action;
+    int64_t seconds = 60;
+    in >> command >> action >> seconds;
 
-    const auto tribe_id = GetTribeIdFromPlayer(pc);
-    if (tribe_id == 0)
+    if (action == "start")
     {
-        SendPlayerMessage(pc, L"Вы должны состоять в племени.");
-        return;
+        seconds = (std::max)(int64_t(1), seconds);
+        if (!StartTrace(static_cast<size_t>((std::max)(64, Cfg().trace_events_per_thread))))
+            return "The last trace is still being written, try again in a moment";
+        trace_stop_at = Now() + seconds;
+        return "Trace started for " + std::to_string(seconds) + " s";
     }
-
-    if (!IsTribeLeaderOrAdmin(pc))
+    if (action == "stop")
     {
-        SendPlayerMessage(pc, L"Только лидер/администратор племени может использовать эту команду.");
-        return;
+        if (!TraceEnabled())
+            return "No trace running";
+        return "Trace written to " + FinishTrace();
     }
+    return "Usage: TribeWar.Trace start [seconds] | stop";
+}
 
-    const auto now = Now();
-    if (GetWarForTribeCopy(tribe_id).has_value() || IsTribeInCooldown(tribe_id, now))
-    {
-        SendPlayerMessage(pc, L"У вашего племени уже есть активная война или откат.");
+void ConsoleCmdTrace(APlayerController* player_controller, FString* message, bool)
+{
+    auto* pc = static_cast<AShooterPlayerController*>(player_controller);
+    if (!pc || !message || !pc->bIsAdmin()())
         return;
-    }
 
-    if (ArkApi::GetApiUtils().GetStatus() != ArkApi::ServerStatus::Ready)
-        return;
+    const FString reply(HandleTraceCommand(message->ToString()).c_str());
+    ArkApi::GetApiUtils().SendChatMessage(pc, FString(L"Mega Tribe War"), L"{}", *reply);
+}
 
-    auto* world = ArkApi::GetApiUtils().GetWorld();
-    if (!world)
+void RconCmdTrace(RCONClientConnection* connection, RCONPacket* packet, UWorld*)
+{
+    if (!connection || !packet)
         return;
+    FString reply(HandleTraceCommand(packet->Body.ToString()).c_str());
+    connection->SendMessageW(packet->Id, 0, &reply);
+}
 
-    // BUGFIX: Build tribe list from currently online players (more reliable than TribesDataField)
-    // This avoids race conditions where TribesDataField may be out of sync with PlayerControllerList
-    std::unordered_set<int64_t> available_tribes;
-    auto& players = world->PlayerControllerListField();
-    for (TWeakObjectPtr<APlayerController>& player : players)
-    {
-        auto* check_pc = static_cast<AShooterPlayerController*>(player.Get());
-        
-        // CRITICAL BUGFIX: Validate player is actually active (not disconnected/pending)
-        if (!check_pc)
-            continue;
-        if (!check_pc->IsValidLowLevelFast(true))
-            continue;
-        if (check_pc->IsA(AShooterPlayerController::StaticClass()) == false)
-            continue;
+// TribeWar.Reload [status]. Reload re-reads config.json on io_worker; the
+// outcome is applied on the next timer tick, sent to the console admin who
+// asked and written to the ArkApi log. "status" reports the last outcome.
+std::string HandleReloadCommand(const std::string& command_line, uint64_t requester)
+{
+    std::istringstream in(command_line);
+    std::string command;
+    std::string action;
+    in >> command >> action;
 
-        const int64_t check_tribe = GetTribeIdFromPlayer(check_pc);
-        if (check_tribe == 0 || check_tribe == tribe_id)
-            continue;
+    if (action == "status")
+        return ConfigReloadStatus();
+    RequestConfigReload(requester);
+    if (requester == 0)
+        return "Config reload queued, TribeWar.Reload status shows the result";
+    return "Config reload queued";
+}
 
-        // Skip if this tribe has an active war or cooldown
-        if (GetWarForTribeCopy(check_tribe).has_value() || IsTribeInCooldown(check_tribe, now))
-            continue;
+void ConsoleCmdReload(APlayerController* player_controller, FString* message, bool)
+{
+    auto* pc = static_cast<AShooterPlayerController*>(player_controller);
+    if (!pc || !message || !pc->bIsAdmin()())
+        return;
 
-        available_tribes.insert(check_tribe);
-    }
+    const FString reply(HandleReloadCommand(message->ToString(), GetPlayerKey(pc)).c_str());
+    ArkApi::GetApiUtils().SendChatMessage(pc, FString(L"Mega Tribe War"), L"{}", *reply);
+}
 
-    if (available_tribes.empty())
-    {
-        SendPlayerMessage(pc, L"Нет доступных племён для объявления войны.");
+void RconCmdReload(RCONClientConnection* connection, RCONPacket* packet, UWorld*)
+{
+    if (!connection || !packet)
         return;
-    }
+    FString reply(HandleReloadCommand(packet->Body.ToString(), 0).c_str());
+    connection->SendMessageW(packet->Id, 0, &reply);
+}
 
-    FString message(L"Список племён:\n");
-    for (const auto other_id : available_tribes)
+// === Chat Commands ===
+#if TRIBEWAR_ENABLE_CHAT_COMMANDS
+
+// Who issued a chat command. RouteChatCommand resolves it once and checks the
+// command's requirements before any handler runs.
+struct CallerContext
+{
+    AShooterPlayerController* pc = nullptr;
+    int64_t tribe_id = 0;
+    bool leader = false; // IsTribeLeaderOrAdmin; only looked up for commands that need a leader
+    bool server_admin = false;
+
+    // The caller's war, fetched on first use.
+    const std::optional<WarView>& War()
     {
-        const FString display_name = GetTribeDisplayName(other_id);
-        if (!display_name.IsEmpty())
-            message += FString::Format(L"{}\n", *display_name);
-        else
-            message += FString::Format(L"ID: {}\n", other_id);
+        if (!war_loaded_)
+        {
+            war_ = war_engine.GetWarForSide(tribe_id);
+            war_loaded_ = true;
+        }
+        return war_;
     }
 
-    message += L"\nИспользуйте /war <tribe_id>, чтобы объявить войну.";
-    SendPlayerMessage(pc, message);
+private:
+    bool war_loaded_ = false;
+    std::optional<WarView> war_;
+};
+
+// What a command needs from its caller; checked in this order.
+enum ChatRequirement : uint8_t
+{
+    kChatAnyone = 0,
+    kChatTribe = 1,
+    kChatLeader = 2 | kChatTribe,
+    kChatServerAdmin = 4,
+};
+
+// `args` are the tokens after the command (and subcommand) name.
+using ChatHandler = void (*)(CallerContext& caller, const CommandLine& args);
+
+// One node of the chat command tree. A message walks down while its next
+// token names a child; the deepest node reached runs with the remaining
+// tokens. Only that node's requirements apply, so "/war admin" needs a server
+// admin but not a tribe.
+struct ChatCommand
+{
+    const wchar_t* name;
+    uint8_t requirements;
+    Stat stat; // of the whole top-level command, subcommands included
+    ChatHandler run;
+    const ChatCommand* children;
+    size_t child_count;
+};
+
+template <size_t N>
+constexpr size_t CountOf(const ChatCommand (&)[N])
+{
+    return N;
 }
 
-void CmdWarDeclareId(AShooterPlayerController* pc, FString* message, EChatSendMode::Type)
+void CmdWarStatus(CallerContext& caller, const CommandLine&)
 {
-    if (!pc || !message)
-        return;
+    const auto& war_view = caller.War();
+    const int64_t side_root = war_view ? war_view->side_root : caller.tribe_id;
+    SendPlayerMessage(caller.pc, GetStatusText(war_view ? &war_view->war : nullptr, side_root));
+}
 
-    const auto tribe_id = GetTribeIdFromPlayer(pc);
-    if (tribe_id == 0)
+constexpr int kWarListPageSize = 15;
+
+// Checks shared by /war list and /war find. Returns nullptr after telling the
+// caller why not.
+const OnlineTargetIndex* BeginWarListing(CallerContext& caller)
+{
+    if (ArkApi::GetApiUtils().GetStatus() != ArkApi::ServerStatus::Ready)
+        return nullptr;
+
+    const auto now = Now();
+    if (GetDeclareTargets(now).IsBusy(caller.tribe_id))
     {
-        SendPlayerMessage(pc, L"Вы должны состоять в племени.");
-        return;
+        SendPlayerMessage(caller.pc, L"У вашего племени уже есть активная война или откат.");
+        return nullptr;
     }
+    return &GetOnlineTargets(now);
+}
 
-    if (!IsTribeLeaderOrAdmin(pc))
-    {
-        SendPlayerMessage(pc, L"Только лидер/администратор племени может использовать эту команду.");
+// /war list <page>: one page of the online tribes that can be declared on.
+void CmdWarList(CallerContext& caller, const CommandLine& args)
+{
+    const auto* index = BeginWarListing(caller);
+    if (!index)
         return;
-    }
 
-    TArray<FString> parsed;
-    message->ParseIntoArray(parsed, L" ", true);
-    // expected: "/war <tribe_id>" or "<tribe_id>" depending on chat hook
-    int arg_index = 0;
-    if (parsed.Num() >= 1 && parsed[0].StartsWith(L"/"))
-        arg_index = 1;
+    uint64_t requested = 1;
+    if (!ParseUInt(args[0], 1000000, requested))
+        requested = 1;
 
-    if (parsed.Num() <= arg_index)
+    // The caller's own tribe is in the index but never listed.
+    const auto tribe_id = caller.tribe_id;
+    const auto& targets = index->targets;
+    const auto self = std::find_if(targets.begin(), targets.end(), [tribe_id](const OnlineTarget& t) { return t.tribe_id == tribe_id; });
+    const auto self_pos = static_cast<size_t>(self - targets.begin());
+    const auto total = targets.size() - (self != targets.end() ? 1 : 0);
+    if (total == 0)
     {
-        SendPlayerMessage(pc, L"Использование: /war <tribe_id>");
+        SendPlayerMessage(caller.pc, L"Нет доступных племён для объявления войны.");
         return;
     }
 
-    int64_t target_id = 0;
-    try
+    const int pages = static_cast<int>((total + kWarListPageSize - 1) / kWarListPageSize);
+    const int page = (std::max)(1, (std::min)(static_cast<int>(requested), pages));
+
+    size_t pos = static_cast<size_t>(page - 1) * kWarListPageSize;
+    if (self_pos <= pos)
+        ++pos;
+
+    FString message = FString::Format(L"Список племён (стр. {}/{}):\n", page, pages);
+    for (int shown = 0; shown < kWarListPageSize && pos < targets.size(); ++pos)
     {
-        const uint64_t raw = std::stoull(parsed[arg_index].ToString());
-        if (raw == 0 || raw > 0xFFFFFFFFULL)
-            throw std::out_of_range("tribe_id");
-        target_id = static_cast<int64_t>(raw);
+        if (pos == self_pos)
+            continue;
+        message += FString::Format(L"{}\n", *targets[pos].name_entry->display);
+        ++shown;
     }
-    catch (...)
+
+    if (pages > 1)
+        message += L"\n/war list <стр.> - другая страница, /war find <начало имени> - поиск";
+    message += L"\nИспользуйте /war <tribe_id>, чтобы объявить войну.";
+    SendPlayerMessage(caller.pc, message);
+}
+
+// /war find <prefix>: online declarable tribes whose name starts with prefix
+// (case-insensitive), at most one page.
+void CmdWarFind(CallerContext& caller, const CommandLine& args)
+{
+    // Tribe names may contain spaces
+    const auto typed = args.Rest(0);
+    if (typed.empty())
     {
-        SendPlayerMessage(pc, L"Некорректный ID племени.");
+        SendPlayerMessage(caller.pc, L"Использование: /war find <начало имени>");
         return;
     }
 
-    const auto now = Now();
-    FString reason;
-    if (!IsWarAllowed(tribe_id, target_id, now, reason))
-    {
-        SendPlayerMessage(pc, reason);
+    const auto* index = BeginWarListing(caller);
+    if (!index)
         return;
-    }
 
-    DeclareWar(tribe_id, target_id);
-}
+    const FString prefix(static_cast<int32_t>(typed.size()), typed.data());
+    const FString key = prefix.ToLower();
+    const auto& targets = index->targets;
+    auto it = std::lower_bound(targets.begin(), targets.end(), key, [](const OnlineTarget& t, const FString& k) {
+        return !t.key.IsEmpty() && std::wcscmp(*t.key, *k) < 0;
+    });
 
-void CmdWarCancel(AShooterPlayerController* pc, FString*, EChatSendMode::Type)
-{
-    if (!pc)
-        return;
+    FString message = FString::Format(L"Племена на \"{}\":\n", *prefix);
+    int matches = 0;
+    for (; it != targets.end() && !it->key.IsEmpty() && std::wcsncmp(*it->key, *key, key.Len()) == 0; ++it)
+    {
+        if (it->tribe_id == caller.tribe_id)
+            continue;
+        if (matches < kWarListPageSize)
+            message += FString::Format(L"{}\n", *it->name_entry->display);
+        ++matches;
+    }
 
-    const auto tribe_id = GetTribeIdFromPlayer(pc);
-    if (tribe_id == 0)
+    if (matches == 0)
     {
-        SendPlayerMessage(pc, L"Вы должны состоять в племени.");
+        SendPlayerMessage(caller.pc, FString::Format(L"Нет доступных племён на \"{}\".", *prefix));
         return;
     }
 
-    if (!IsTribeLeaderOrAdmin(pc))
+    if (matches > kWarListPageSize)
+        message += FString::Format(L"...и ещё {}, уточните запрос.\n", matches - kWarListPageSize);
+    message += L"\nИспользуйте /war <tribe_id>, чтобы объявить войну.";
+    SendPlayerMessage(caller.pc, message);
+}
+
+void CmdWarDeclareId(CallerContext& caller, std::wstring_view token)
+{
+    uint64_t raw = 0;
+    if (!ParseUInt(token, 0xFFFFFFFFULL, raw) || raw == 0)
     {
-        SendPlayerMessage(pc, L"Только лидер/администратор племени может использовать эту команду.");
+        SendPlayerMessage(caller.pc, L"Некорректный ID племени.");
         return;
     }
 
-    if (!GetWarForTribeCopy(tribe_id).has_value())
+    const auto target_id = static_cast<int64_t>(raw);
+    FString reason;
+    if (!IsWarAllowed(caller.tribe_id, target_id, Now(), reason))
     {
-        SendPlayerMessage(pc, L"Нет активной войны.");
+        SendPlayerMessage(caller.pc, reason);
         return;
     }
 
-    RequestCancelWar(tribe_id);
+    DeclareWar(caller.tribe_id, target_id);
 }
 
-void CmdWarAcceptCancel(AShooterPlayerController* pc, FString*, EChatSendMode::Type)
+// /war => list; /war <tribe_id> => declare; anything else => list.
+void CmdWar(CallerContext& caller, const CommandLine& args)
 {
-    if (!pc)
-        return;
-
-    const auto tribe_id = GetTribeIdFromPlayer(pc);
-    if (tribe_id == 0)
+    const auto arg = args[0];
+    if (!arg.empty() && ((arg[0] >= L'0' && arg[0] <= L'9') || arg[0] == L'-' || arg[0] == L'+'))
     {
-        SendPlayerMessage(pc, L"Вы должны состоять в племени.");
+        CmdWarDeclareId(caller, arg);
         return;
     }
+    CmdWarList(caller, CommandLine());
+}
 
-    if (!IsTribeLeaderOrAdmin(pc))
+void CmdWarCancel(CallerContext& caller, const CommandLine&)
+{
+    if (!caller.War().has_value())
     {
-        SendPlayerMessage(pc, L"Только лидер/администратор племени может использовать эту команду.");
+        SendPlayerMessage(caller.pc, L"Нет активной войны.");
         return;
     }
 
-    if (!GetWarForTribeCopy(tribe_id).has_value())
+    RequestCancelWar(caller.tribe_id);
+}
+
+void CmdWarAcceptCancel(CallerContext& caller, const CommandLine&)
+{
+    if (!caller.War().has_value())
     {
-        SendPlayerMessage(pc, L"Нет активной войны.");
+        SendPlayerMessage(caller.pc, L"Нет активной войны.");
         return;
     }
 
-    if (!HasIncomingCancel(tribe_id))
+    if (!war_engine.HasIncomingCancel(caller.tribe_id))
     {
-        SendPlayerMessage(pc, L"Запрос на отмену не получен.");
+        SendPlayerMessage(caller.pc, L"Запрос на отмену не получен.");
         return;
     }
 
-    AcceptCancelWar(tribe_id);
+    AcceptCancelWar(caller.tribe_id);
 }
 
-void CmdWarHelp(AShooterPlayerController* pc, FString*, EChatSendMode::Type)
+void CmdWarHelp(CallerContext& caller, const CommandLine&)
 {
-    if (!pc)
-        return;
-
     FString help(L"Краткая справка по командам:\n");
     help += L"/info - краткая справка по командам\n";
     help += L"/status - статус текущей войны\n";
-    help += L"/war - список доступных племён для объявления\n";
+    help += L"/war list [стр.] - список доступных племён для объявления\n";
+    help += L"/war find <начало имени> - поиск племени по имени\n";
     help += L"/war <tribe_id> - объявить войну выбранному племени\n";
     help += L"/stop - запросить отмену войны\n";
     help += L"/accept - принять запрос на отмену\n";
-    SendPlayerMessage(pc, help);
+    if (caller.server_admin)
+        help += L"/war admin - команды администратора\n";
+    SendPlayerMessage(caller.pc, help);
+}
+
+void CmdAdminHelp(CallerContext& caller, const CommandLine&)
+{
+    FString help(L"Команды администратора:\n");
+    help += L"/war admin stats - счётчики плагина (как TribeWar.Stats)\n";
+    help += L"/war admin trace start [сек] | stop - запись трассировки (как TribeWar.Trace)\n";
+    help += L"/war admin reload [status] - перечитать config.json или показать итог (как TribeWar.Reload)\n";
+    SendPlayerMessage(caller.pc, help);
+}
+
+void CmdAdminStats(CallerContext& caller, const CommandLine&)
+{
+    SendReportLines(caller.pc, StatsReport());
+    io_worker.Post([path = GetStatsPath(), now = Now()]() { WriteStatsFile(path, now); });
+}
+
+void CmdAdminTrace(CallerContext& caller, const CommandLine& args)
+{
+    // HandleTraceCommand skips the command word, as sent by the console.
+    const auto rest = args.Rest(0);
+    const FString line = FString(L"trace ") + FString(static_cast<int32_t>(rest.size()), rest.data());
+    SendPlayerMessage(caller.pc, FString(HandleTraceCommand(line.ToString()).c_str()));
+}
+
+void CmdAdminReload(CallerContext& caller, const CommandLine& args)
+{
+    // HandleReloadCommand skips the command word, as sent by the console.
+    const auto rest = args.Rest(0);
+    const FString line = FString(L"reload ") + FString(static_cast<int32_t>(rest.size()), rest.data());
+    SendPlayerMessage(caller.pc, FString(HandleReloadCommand(line.ToString(), GetPlayerKey(caller.pc)).c_str()));
 }
 
-void CmdWar(AShooterPlayerController* pc, FString* message, EChatSendMode::Type mode)
+constexpr ChatCommand kAdminCommands[] = {
+    { L"stats", kChatServerAdmin, Stat::CmdWar, &CmdAdminStats, nullptr, 0 },
+    { L"trace", kChatServerAdmin, Stat::CmdWar, &CmdAdminTrace, nullptr, 0 },
+    { L"reload", kChatServerAdmin, Stat::CmdWar, &CmdAdminReload, nullptr, 0 },
+};
+
+constexpr ChatCommand kWarCommands[] = {
+    { L"list", kChatLeader, Stat::CmdWar, &CmdWarList, nullptr, 0 },
+    { L"find", kChatLeader, Stat::CmdWar, &CmdWarFind, nullptr, 0 },
+    { L"admin", kChatServerAdmin, Stat::CmdWar, &CmdAdminHelp, kAdminCommands, CountOf(kAdminCommands) },
+};
+
+// Top-level chat registrations; each is added with AddChatCommand in Load.
+constexpr ChatCommand kChatCommands[] = {
+    { L"/info", kChatAnyone, Stat::CmdInfo, &CmdWarHelp, nullptr, 0 },
+    { L"/status", kChatLeader, Stat::CmdStatus, &CmdWarStatus, nullptr, 0 },
+    { L"/war", kChatLeader, Stat::CmdWar, &CmdWar, kWarCommands, CountOf(kWarCommands) },
+    { L"/stop", kChatLeader, Stat::CmdStop, &CmdWarCancel, nullptr, 0 },
+    { L"/accept", kChatLeader, Stat::CmdAccept, &CmdWarAcceptCancel, nullptr, 0 },
+};
+
+void RouteChatCommand(const ChatCommand& root, AShooterPlayerController* pc, FString* message)
 {
+    StatScope stat(root.stat);
     if (!pc)
         return;
 
-    // /war => list; /war <tribe_id> => declare
-    if (!message)
+    // The hook passes "/war 123" or just "123" depending on the version.
+    CommandLine args = message ? CommandLine(std::wstring_view(**message, static_cast<size_t>(message->Len()))) : CommandLine();
+    if (!args.Empty() && args[0][0] == L'/')
+        args = args.Shift(1);
+
+    const ChatCommand* command = &root;
+    while (!args.Empty())
     {
-        CmdWarDeclare(pc, message, mode);
-        return;
+        const ChatCommand* child = nullptr;
+        for (size_t i = 0; i < command->child_count; ++i)
+        {
+            if (EqualsIgnoreCaseAscii(args[0], command->children[i].name))
+            {
+                child = &command->children[i];
+                break;
+            }
+        }
+        if (!child)
+            break;
+        command = child;
+        args = args.Shift(1);
     }
 
-    TArray<FString> parsed;
-    message->ParseIntoArray(parsed, L" ", true);
+    CallerContext caller;
+    caller.pc = pc;
+    caller.tribe_id = GetTribeIdFromPlayer(pc);
+    caller.server_admin = pc->bIsAdmin()();
 
-    if (parsed.Num() <= 1)
+    if ((command->requirements & kChatServerAdmin) && !caller.server_admin)
     {
-        CmdWarDeclare(pc, message, mode);
+        SendPlayerMessage(pc, L"Команда доступна только администратору сервера.");
         return;
     }
-
-    // Try to support both message formats:
-    // 1) "/war 123"  => parsed[0]="/war", parsed[1]="123"
-    // 2) "123"       => parsed[0]="123"
-    int arg_index = 0;
-    if (parsed[0].StartsWith(L"/"))
-        arg_index = 1;
-
-    if (parsed.Num() <= arg_index)
+    if ((command->requirements & kChatTribe) && caller.tribe_id == 0)
     {
-        CmdWarDeclare(pc, message, mode);
+        SendPlayerMessage(pc, L"Вы должны состоять в племени.");
         return;
     }
+    if (command->requirements & (kChatLeader & ~kChatTribe))
+    {
+        caller.leader = IsTribeLeaderOrAdmin(pc, caller.tribe_id);
+        if (!caller.leader)
+        {
+            SendPlayerMessage(pc, L"Только лидер/администратор племени может использовать эту команду.");
+            return;
+        }
+    }
 
-    // If the next token looks like a number, treat it as tribe_id; otherwise list.
-    const FString& arg = parsed[arg_index];
-    if (arg.IsNumeric())
-        CmdWarDeclareId(pc, message, mode);
-    else
-        CmdWarDeclare(pc, message, mode);
+    command->run(caller, args);
 }
 
 #endif // TRIBEWAR_ENABLE_CHAT_COMMANDS
 
+// Runs the war-lifecycle simulation on io_worker against its own engine and
+// world; the live war state is not touched. The report goes to the self-test log.
+void StartSelfTestSimulation()
+{
+    if (!Cfg().self_test || !Cfg().self_test_simulate)
+        return;
+
+    SimulationOptions options;
+    options.seed = static_cast<uint64_t>(Cfg().self_test_sim_seed);
+    options.tribes = Cfg().self_test_sim_tribes;
+    options.wars = Cfg().self_test_sim_wars;
+    options.ticks = Cfg().self_test_sim_ticks;
+    options.cancel = &self_test_sim_cancel;
+
+    io_worker.Post([sim_config = Cfg(), options, path = GetPluginDir() + "/self_test_sim.json"]() {
+        TRIBEWAR_LOG_INFO(self_test_log, "Simulation: started seed=" + std::to_string(options.seed) + " tribes=" + std::to_string(options.tribes) +
+                                             " wars=" + std::to_string(options.wars) + " ticks=" + std::to_string(options.ticks));
+        const auto report = RunWarSimulation(sim_config, options, path);
+        TRIBEWAR_LOG_INFO(self_test_log, "Simulation: " + report.Summary());
+        for (const auto& violation : report.violations)
+            TRIBEWAR_LOG_WARN(self_test_log, "Simulation: VIOLATION " + violation);
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    });
+}
+
 void InitPlugin()
 {
     if (plugin_initialized)
         return;
 
     std::filesystem::create_directories(GetPluginDir());
-    LoadConfig();
+    const auto config_fixes = LoadConfig();
+    self_test_log.Open(GetSelfTestLogPath(), static_cast<uint64_t>((std::max)(int64_t(0), Cfg().log_max_bytes)), Cfg().log_keep_files);
+    multiuse_log.Open(GetMultiUseDebugLogPath(), static_cast<uint64_t>((std::max)(int64_t(0), Cfg().log_max_bytes)), Cfg().log_keep_files);
+    war_engine.SetSelfTestLog(&self_test_log);
+    for (const auto& fix : config_fixes)
+        TRIBEWAR_LOG_WARN(self_test_log, "Config: fixed " + fix);
     LoadData();
     LoadTribeNameCache();
+    io_worker.Start();
+    io_worker.Post([path = GetConfigPath()]() { ConfigFileChanged(path); }); // baseline for config_poll_seconds
 
-    AppendMultiUseDebugLog(std::string("InitPlugin: enable_multiuse_menu=") + (config.enable_multiuse_menu ? "true" : "false") +
-                           " require_owned=" + (config.multiuse_require_owned_structure ? "true" : "false") +
-                           " require_leader=" + (config.multiuse_require_leader ? "true" : "false") +
-                           " max_targets=" + std::to_string(config.multiuse_max_targets));
+    TRIBEWAR_LOGF_DEBUG(multiuse_log, "InitPlugin: enable_multiuse_menu={} require_owned={} require_leader={} max_targets={}",
+                        Cfg().enable_multiuse_menu, Cfg().multiuse_require_owned_structure, Cfg().multiuse_require_leader,
+                        Cfg().multiuse_max_targets);
 
     // Ensure data.json gets created even on empty state and even if the process
     // terminates without a clean plugin unload.
     if (!FileExists(GetDataPath()))
-        need_save.store(true);
+        war_engine.MarkDirty();
 
-    SeedSelfTestWarIfNeeded();
-    if (config.self_test)
-        need_save.store(true);
+    war_engine.SeedSelfTestWar(Now());
+    if (Cfg().self_test)
+        war_engine.MarkDirty();
+    StartSelfTestSimulation();
 
+    SetupTimerStages();
     ArkApi::GetCommands().AddOnTimerCallback("TribeWarSystem_Timer", &TimerCallback);
 
     plugin_initialized = true;
@@ -2714,27 +2621,35 @@ void Load()
             try
             {
                 ArkApi::GetHooks().SetHook(name, hook_fn, original_fn);
-                AppendMultiUseDebugLog(std::string("SetHook OK: ") + name);
+                TRIBEWAR_LOGF_DEBUG(multiuse_log, "SetHook OK: {}", name);
             }
             catch (const std::exception& e)
             {
-                AppendMultiUseDebugLog(std::string("SetHook FAIL: ") + name + " ex=" + e.what());
+                TRIBEWAR_LOGF_DEBUG(multiuse_log, "SetHook FAIL: {} ex={}", name, e.what());
             }
             catch (...)
             {
-                AppendMultiUseDebugLog(std::string("SetHook FAIL: ") + name + " ex=unknown");
+                TRIBEWAR_LOGF_DEBUG(multiuse_log, "SetHook FAIL: {} ex=unknown", name);
             }
         };
 
         ArkApi::GetHooks().SetHook("AShooterGameMode.Tick", &Hook_AShooterGameMode_Tick, &AShooterGameMode_Tick_original);
         ArkApi::GetHooks().SetHook("APrimalStructure.TakeDamage", &Hook_APrimalStructure_TakeDamage, &APrimalStructure_TakeDamage_original);
 
+        ArkApi::GetCommands().AddConsoleCommand("TribeWar.Stats", &ConsoleCmdStats);
+        ArkApi::GetCommands().AddRconCommand("TribeWar.Stats", &RconCmdStats);
+        ArkApi::GetCommands().AddConsoleCommand("TribeWar.Trace", &ConsoleCmdTrace);
+        ArkApi::GetCommands().AddRconCommand("TribeWar.Trace", &RconCmdTrace);
+        ArkApi::GetCommands().AddConsoleCommand("TribeWar.Reload", &ConsoleCmdReload);
+        ArkApi::GetCommands().AddRconCommand("TribeWar.Reload", &RconCmdReload);
+
 #if TRIBEWAR_ENABLE_CHAT_COMMANDS
-        ArkApi::GetCommands().AddChatCommand("/info", &CmdWarHelp);
-        ArkApi::GetCommands().AddChatCommand("/status", &CmdWarStatus);
-        ArkApi::GetCommands().AddChatCommand("/war", &CmdWar);
-        ArkApi::GetCommands().AddChatCommand("/stop", &CmdWarCancel);
-        ArkApi::GetCommands().AddChatCommand("/accept", &CmdWarAcceptCancel);
+        for (const auto& command : kChatCommands)
+        {
+            ArkApi::GetCommands().AddChatCommand(command.name, [&command](AShooterPlayerController* pc, FString* message, EChatSendMode::Type) {
+                RouteChatCommand(command, pc, message);
+            });
+        }
 #endif
 
         // MultiUse hooks disabled due to FMultiUseEntry structure incompatibility with ARK 361.7
@@ -2762,23 +2677,42 @@ void Load()
     }
 }
 
-void Unload()
+// `in_dll_main`: called under the loader lock, where the worker thread cannot
+// be joined. At process exit the OS has already ended it; on FreeLibrary
+// Plugin_Unload normally stopped it before.
+void Unload(bool in_dll_main)
 {
+    if (plugin_unloaded)
+        return;
+    plugin_unloaded = true;
+
     try
     {
         if (plugin_initialized)
         {
             SaveData();
-            SaveTribeNameCache();
+            CompactTribeNameCache();
         }
+        if (TraceEnabled())
+            FinishTrace();
+        self_test_sim_cancel.store(true);
+        if (in_dll_main)
+            io_worker.Abandon(); // writes what is still queued on this thread
+        else
+            io_worker.Stop();
+        self_test_log.Close();
+        multiuse_log.Close();
 
 #if TRIBEWAR_ENABLE_CHAT_COMMANDS
-        ArkApi::GetCommands().RemoveChatCommand("/info");
-        ArkApi::GetCommands().RemoveChatCommand("/status");
-        ArkApi::GetCommands().RemoveChatCommand("/war");
-        ArkApi::GetCommands().RemoveChatCommand("/stop");
-        ArkApi::GetCommands().RemoveChatCommand("/accept");
+        for (const auto& command : kChatCommands)
+            ArkApi::GetCommands().RemoveChatCommand(command.name);
 #endif
+        ArkApi::GetCommands().RemoveConsoleCommand("TribeWar.Stats");
+        ArkApi::GetCommands().RemoveRconCommand("TribeWar.Stats");
+        ArkApi::GetCommands().RemoveConsoleCommand("TribeWar.Trace");
+        ArkApi::GetCommands().RemoveRconCommand("TribeWar.Trace");
+        ArkApi::GetCommands().RemoveConsoleCommand("TribeWar.Reload");
+        ArkApi::GetCommands().RemoveRconCommand("TribeWar.Reload");
 
         ArkApi::GetCommands().RemoveOnTimerCallback("TribeWarSystem_Timer");
         
@@ -2811,6 +2745,13 @@ void Unload()
 
 } // namespace
 
+// Called by the ArkApi plugin manager before FreeLibrary, outside the loader
+// lock, so the worker thread can finish its queue and be joined.
+extern "C" __declspec(dllexport) void Plugin_Unload()
+{
+    Unload(false);
+}
+
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved)
 {
     switch (ul_reason_for_call)
@@ -2819,7 +2760,9 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
         Load();
         break;
     case DLL_PROCESS_DETACH:
-        Unload();
+        // No-op after Plugin_Unload. lpReserved != nullptr means the process
+        // is exiting: other threads are gone, nothing is waited for.
+        Unload(true);
         break;
     }
     return TRUE;
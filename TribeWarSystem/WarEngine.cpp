@@ -0,0 +1,921 @@
+#include "WarEngine.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include "json.hpp"
+
+int64_t CanonicalTribeId(int64_t raw_id)
+{
+    // ARK tribe/team IDs are effectively 32-bit values.
+    // Normalize to unsigned 32-bit to avoid negative IDs in UI and comparisons.
+    const auto as_i32 = static_cast<int32_t>(raw_id);
+    const auto as_u32 = static_cast<uint32_t>(as_i32);
+    return static_cast<int64_t>(as_u32);
+}
+
+WarPhase GetPhase(const WarRecord& war, int64_t now)
+{
+    if (war.war_id == 0)
+        return WarPhase::None;
+
+    if (war.ended_at == 0)
+    {
+        if (now < war.start_at)
+            return WarPhase::Pending;
+        return WarPhase::Active;
+    }
+
+    if (now < war.cooldown_end_a || now < war.cooldown_end_b)
+        return WarPhase::Cooldown;
+
+    return WarPhase::None;
+}
+
+bool IsActiveWar(const WarRecord& war, int64_t now)
+{
+    return GetPhase(war, now) == WarPhase::Active;
+}
+
+bool IsStaleWarRecord(const WarRecord& war, int64_t now, int32_t cooldown_seconds)
+{
+    if (war.ended_at == 0)
+        return false;
+
+    // BUGFIX: Ignore expired wars (avoid stale data from file)
+    // If war is ended and both cooldowns are expired, skip it
+    if (war.cooldown_end_a > 0 && war.cooldown_end_b > 0 &&
+        now >= war.cooldown_end_a && now >= war.cooldown_end_b)
+    {
+        return true;
+    }
+
+    // Also discard if war is WAY too old (data corruption safety)
+    const int64_t max_cooldown = static_cast<int64_t>(cooldown_seconds) * 2 + 3600; // allow 2x cooldown + 1hr buffer
+    return war.declared_at > 0 && now - war.declared_at > max_cooldown;
+}
+
+// The message is only built when self-test logging is on.
+#define SELF_TEST_LOG(...)                                       \
+    do                                                           \
+    {                                                            \
+        if (Cfg().self_test && self_test_log_)                 \
+            TRIBEWAR_LOG_INFO(*self_test_log_, __VA_ARGS__);     \
+    } while (0)
+
+void WarEngine::SetConfig(std::shared_ptr<const ConfigSnapshot> snapshot)
+{
+    if (!snapshot)
+        return;
+    auto active = std::make_unique<ActiveConfig>();
+    active->damage_policy = SelectDamagePolicy(*snapshot);
+    active->snapshot = std::move(snapshot);
+
+    DataLockGuard lock(mutex_);
+    config_.store(active.get(), std::memory_order_release);
+    if (active_config_)
+        retired_configs_.push_back(RetiredConfig{ std::move(active_config_), alliance_generation_ });
+    active_config_ = std::move(active);
+}
+
+WarRecord* WarEngine::FindWarLocked(int64_t war_id)
+{
+    const auto it = wars_by_id_.find(war_id);
+    return it == wars_by_id_.end() ? nullptr : &it->second;
+}
+
+WarRecord* WarEngine::GetWarForTribeLocked(int64_t tribe_id)
+{
+    const auto index = registry_.Find(tribe_id);
+    if (index == kNoTribeIndex || registry_.war_id[index] == 0)
+        return nullptr;
+
+    return FindWarLocked(registry_.war_id[index]);
+}
+
+void WarEngine::RefreshWarSidesLocked()
+{
+    war_sides_.Refresh(alliance_generation_, war_state_version_.load(std::memory_order_acquire), [this]() {
+        std::vector<WarSideRoots> roots;
+        roots.reserve(wars_by_id_.size());
+        for (const auto& it : wars_by_id_)
+            roots.push_back(WarSideRoots{ it.second.war_id, it.second.tribe_a, it.second.tribe_b });
+        return roots;
+    });
+}
+
+void WarEngine::GetWarSides(int64_t tribe_id, std::vector<SideMembership>& out)
+{
+    out.clear();
+    WarSideCache::Roots roots;
+    uint64_t epoch = 0;
+    {
+        DataLockGuard lock(mutex_);
+        RefreshWarSidesLocked();
+        if (!war_sides_.HasWars())
+            return;
+        uint32_t count = 0;
+        if (const auto* sides = war_sides_.Find(tribe_id, count))
+        {
+            out.assign(sides, sides + count);
+            return;
+        }
+        roots = war_sides_.GetRoots();
+        epoch = war_sides_.Epoch();
+    }
+
+    // The world's alliance check is a game call; keep it out of the lock.
+    WarSideCache::Collect(world_, *roots, tribe_id, out);
+
+    DataLockGuard lock(mutex_);
+    war_sides_.Store(tribe_id, epoch, out);
+}
+
+void WarEngine::RebuildTribeIndexLocked(int64_t now)
+{
+    war_state_version_.fetch_add(1, std::memory_order_release);
+    std::fill(registry_.war_id.begin(), registry_.war_id.end(), 0);
+    std::fill(registry_.cooldown_end.begin(), registry_.cooldown_end.end(), 0);
+    for (const auto& it : wars_by_id_)
+    {
+        const auto& war = it.second;
+        const auto phase = GetPhase(war, now);
+        if (phase == WarPhase::None)
+            continue;
+
+        const auto a = registry_.Intern(war.tribe_a);
+        const auto b = registry_.Intern(war.tribe_b);
+        registry_.war_id[a] = war.war_id;
+        registry_.war_id[b] = war.war_id;
+        if (war.ended_at != 0)
+        {
+            registry_.cooldown_end[a] = war.cooldown_end_a;
+            registry_.cooldown_end[b] = war.cooldown_end_b;
+        }
+    }
+}
+
+void WarEngine::BeginTick()
+{
+    DataLockGuard lock(mutex_);
+    ++alliance_generation_;
+
+    size_t expired = 0;
+    while (expired < retired_configs_.size() &&
+           alliance_generation_ - retired_configs_[expired].retired_generation >= kConfigGraceTicks)
+        ++expired;
+    retired_configs_.erase(retired_configs_.begin(), retired_configs_.begin() + static_cast<std::ptrdiff_t>(expired));
+}
+
+std::optional<WarRecord> WarEngine::GetWarForTribe(int64_t tribe_id)
+{
+    tribe_id = CanonicalTribeId(tribe_id);
+    const auto now = clock_.Now();
+    DataLockGuard lock(mutex_);
+    if (auto* war = GetWarForTribeLocked(tribe_id))
+    {
+        if (GetPhase(*war, now) == WarPhase::None)
+            return std::nullopt;
+        return *war;
+    }
+    return std::nullopt;
+}
+
+std::optional<WarView> WarEngine::GetWarForSide(int64_t tribe_id)
+{
+    if (tribe_id == 0)
+        return std::nullopt;
+
+    // Fast path: direct participant.
+    if (auto direct = GetWarForTribe(tribe_id))
+    {
+        const auto& war = *direct;
+        const int64_t side_root = (tribe_id == war.tribe_a) ? war.tribe_a : war.tribe_b;
+        return WarView{ war, side_root };
+    }
+
+    std::vector<SideMembership> sides;
+    GetWarSides(tribe_id, sides);
+    if (sides.empty())
+        return std::nullopt;
+
+    const auto now = clock_.Now();
+    DataLockGuard lock(mutex_);
+    for (const auto& side : sides)
+    {
+        if (side.sides != kWarSideA && side.sides != kWarSideB)
+            continue; // allied to both roots: on neither side
+        const auto* war = FindWarLocked(side.war_id);
+        if (!war || GetPhase(*war, now) == WarPhase::None)
+            continue;
+        return WarView{ *war, side.sides == kWarSideA ? war->tribe_a : war->tribe_b };
+    }
+
+    return std::nullopt;
+}
+
+bool WarEngine::IsTribeInCooldown(int64_t tribe_id, int64_t now)
+{
+    tribe_id = CanonicalTribeId(tribe_id);
+    DataLockGuard lock(mutex_);
+    // cooldown_end is only set for ended wars that are still indexed.
+    const auto index = registry_.Find(tribe_id);
+    if (index == kNoTribeIndex)
+        return false;
+    return now < registry_.cooldown_end[index];
+}
+
+int64_t WarEngine::CollectBusyTribesLocked(int64_t now, std::vector<int64_t>& out)
+{
+    int64_t frees_at = (std::numeric_limits<int64_t>::max)();
+    for (TribeIndex index = 0; index < registry_.Size(); ++index)
+    {
+        int64_t busy_until = now < registry_.cooldown_end[index] ? registry_.cooldown_end[index] : 0;
+        if (registry_.war_id[index] != 0)
+        {
+            if (const auto* war = FindWarLocked(registry_.war_id[index]))
+            {
+                const auto phase = GetPhase(*war, now);
+                if (phase == WarPhase::Pending || phase == WarPhase::Active)
+                    busy_until = (std::numeric_limits<int64_t>::max)(); // ends only through a state change
+                else if (phase == WarPhase::Cooldown)
+                    busy_until = (std::max)({ busy_until, war->cooldown_end_a, war->cooldown_end_b });
+            }
+        }
+        if (busy_until == 0)
+            continue;
+
+        out.push_back(registry_.tribe_id[index]);
+        frees_at = (std::min)(frees_at, busy_until);
+    }
+    return frees_at;
+}
+
+bool WarEngine::HasIncomingCancel(int64_t tribe_id)
+{
+    tribe_id = CanonicalTribeId(tribe_id);
+    DataLockGuard lock(mutex_);
+    auto* war = GetWarForTribeLocked(tribe_id);
+    if (!war)
+        return false;
+
+    if (tribe_id == war->tribe_a)
+        return war->cancel_requested_by_b;
+    if (tribe_id == war->tribe_b)
+        return war->cancel_requested_by_a;
+    return false;
+}
+
+bool WarEngine::HasWars()
+{
+    DataLockGuard lock(mutex_);
+    return !wars_by_id_.empty();
+}
+
+std::vector<WarRecord> WarEngine::GetWars()
+{
+    std::vector<WarRecord> wars;
+    {
+        DataLockGuard lock(mutex_);
+        wars.reserve(wars_by_id_.size());
+        for (const auto& it : wars_by_id_)
+            wars.push_back(it.second);
+    }
+    std::sort(wars.begin(), wars.end(), [](const WarRecord& a, const WarRecord& b) { return a.war_id < b.war_id; });
+    return wars;
+}
+
+std::vector<std::string> WarEngine::CheckInvariants(int64_t now)
+{
+    std::vector<std::string> problems;
+    const auto war_text = [](const WarRecord& war) {
+        return "war " + std::to_string(war.war_id) + " (" + std::to_string(war.tribe_a) + " vs " + std::to_string(war.tribe_b) + ")";
+    };
+
+    DataLockGuard lock(mutex_);
+    FlatHashMap<int64_t, int64_t> war_of_tribe;
+    for (const auto& it : wars_by_id_)
+    {
+        const auto& war = it.second;
+        if (it.first != war.war_id || war.war_id <= 0 || war.war_id >= next_war_id_)
+            problems.push_back(war_text(war) + ": bad id, table key " + std::to_string(it.first));
+        if (war.tribe_a == 0 || war.tribe_b == 0 || war.tribe_a == war.tribe_b)
+            problems.push_back(war_text(war) + ": bad sides");
+        if (war.start_at < war.declared_at)
+            problems.push_back(war_text(war) + ": starts before it was declared");
+        if (war.ended_at != 0 && (war.cooldown_end_a < war.ended_at || war.cooldown_end_b < war.ended_at))
+            problems.push_back(war_text(war) + ": cooldown ends before the war ended");
+        if (GetPhase(war, now) == WarPhase::None)
+            continue;
+
+        for (const auto tribe : { war.tribe_a, war.tribe_b })
+        {
+            auto inserted = war_of_tribe.try_emplace(tribe);
+            if (!inserted.second)
+                problems.push_back("tribe " + std::to_string(tribe) + " is in war " + std::to_string(inserted.first->second) +
+                                   " and war " + std::to_string(war.war_id));
+            inserted.first->second = war.war_id;
+
+            const auto index = registry_.Find(tribe);
+            if (index == kNoTribeIndex || registry_.war_id[index] != war.war_id)
+                problems.push_back(war_text(war) + ": tribe " + std::to_string(tribe) + " not indexed");
+            else if (war.ended_at != 0 &&
+                     registry_.cooldown_end[index] != (tribe == war.tribe_a ? war.cooldown_end_a : war.cooldown_end_b))
+                problems.push_back(war_text(war) + ": tribe " + std::to_string(tribe) + " cooldown index mismatch");
+        }
+    }
+
+    for (size_t index = 0; index < registry_.Size(); ++index)
+    {
+        const int64_t war_id = registry_.war_id[index];
+        if (war_id == 0)
+            continue;
+        const auto* war = FindWarLocked(war_id);
+        const int64_t tribe = registry_.tribe_id[index];
+        if (!war || (war->tribe_a != tribe && war->tribe_b != tribe))
+            problems.push_back("tribe " + std::to_string(tribe) + " indexed to war " + std::to_string(war_id) + " it is not part of");
+    }
+
+    return problems;
+}
+
+WarDenyReason WarEngine::CheckWarAllowed(int64_t tribe_a, int64_t tribe_b, int64_t now)
+{
+    tribe_a = CanonicalTribeId(tribe_a);
+    tribe_b = CanonicalTribeId(tribe_b);
+    if (tribe_a == 0 || tribe_b == 0)
+        return WarDenyReason::NoTribe;
+
+    if (tribe_a == tribe_b)
+        return WarDenyReason::SameTribe;
+
+    if (world_.IsReady() && world_.AreTribesAllied(tribe_a, tribe_b))
+        return WarDenyReason::Allied;
+
+    if (GetWarForTribe(tribe_a).has_value() || GetWarForTribe(tribe_b).has_value())
+        return WarDenyReason::AlreadyInWar;
+
+    if (!world_.IsTribeOnline(tribe_b))
+        return WarDenyReason::TargetOffline;
+
+    if (IsTribeInCooldown(tribe_a, now) || IsTribeInCooldown(tribe_b, now))
+        return WarDenyReason::Cooldown;
+
+    return WarDenyReason::None;
+}
+
+WarRecord WarEngine::DeclareWar(int64_t tribe_a, int64_t tribe_b)
+{
+    tribe_a = CanonicalTribeId(tribe_a);
+    tribe_b = CanonicalTribeId(tribe_b);
+    WarRecord war;
+    {
+        DataLockGuard lock(mutex_);
+        war.war_id = next_war_id_++;
+        war.tribe_a = tribe_a;
+        war.tribe_b = tribe_b;
+        war.declared_at = clock_.Now();
+        war.start_at = war.declared_at + Cfg().war_delay_seconds;
+        wars_by_id_[war.war_id] = war;
+        RebuildTribeIndexLocked(war.declared_at);
+    }
+    MarkDirty();
+    return war;
+}
+
+int64_t WarEngine::RequestCancelWar(int64_t tribe_id)
+{
+    tribe_id = CanonicalTribeId(tribe_id);
+    int64_t other = 0;
+    {
+        DataLockGuard lock(mutex_);
+        auto* war = GetWarForTribeLocked(tribe_id);
+        if (!war)
+            return 0;
+        if (war->ended_at != 0)
+            return 0;
+
+        if (tribe_id == war->tribe_a)
+            war->cancel_requested_by_a = true;
+        else if (tribe_id == war->tribe_b)
+            war->cancel_requested_by_b = true;
+
+        other = tribe_id == war->tribe_a ? war->tribe_b : war->tribe_a;
+    }
+    MarkDirty();
+    return other;
+}
+
+std::optional<WarRecord> WarEngine::AcceptCancelWar(int64_t tribe_id)
+{
+    tribe_id = CanonicalTribeId(tribe_id);
+    WarRecord snapshot;
+
+    {
+        DataLockGuard lock(mutex_);
+        auto* war = GetWarForTribeLocked(tribe_id);
+        if (!war)
+            return std::nullopt;
+        if (war->ended_at != 0)
+            return std::nullopt;
+
+        if (tribe_id == war->tribe_a)
+            war->cancel_requested_by_a = true;
+        else if (tribe_id == war->tribe_b)
+            war->cancel_requested_by_b = true;
+
+        if (!(war->cancel_requested_by_a && war->cancel_requested_by_b))
+            return std::nullopt;
+
+        const auto now = clock_.Now();
+        war->ended_at = now;
+        war->cooldown_end_a = now + Cfg().cooldown_seconds;
+        war->cooldown_end_b = now + Cfg().cooldown_seconds;
+        war->cancel_requested_by_a = false;
+        war->cancel_requested_by_b = false;
+        war->cooldown_notified = false;
+        snapshot = *war;
+        RebuildTribeIndexLocked(now);
+    }
+    MarkDirty();
+    return snapshot;
+}
+
+std::vector<WarEvent> WarEngine::ProcessTimers(int64_t now)
+{
+    std::vector<WarEvent> events;
+
+    if (!timers_enabled_)
+        return events;
+
+    try
+    {
+        bool changed = false;
+        {
+            DataLockGuard lock(mutex_);
+            if (wars_by_id_.empty())
+                return events;
+
+            // IMPORTANT: never erase from the war table while iterating it.
+            // Collect IDs to remove first, then erase after the loop.
+            std::vector<int64_t> war_ids_to_remove;
+
+            for (auto& it : wars_by_id_)
+            {
+                auto& war = it.second;
+                if (war.war_id == 0 || war.tribe_a == 0 || war.tribe_b == 0)
+                    continue;
+                if (war.start_at == 0 && war.declared_at != 0)
+                    war.start_at = war.declared_at + Cfg().war_delay_seconds;
+                if (war.start_at == 0)
+                    war.start_at = now + Cfg().war_delay_seconds;
+                if (war.ended_at == 0 && now >= war.start_at && !war.start_notified)
+                {
+                    events.push_back(WarEvent{ WarEventType::Started, war.tribe_a, war.war_id });
+                    events.push_back(WarEvent{ WarEventType::Started, war.tribe_b, war.war_id });
+                    war.start_notified = true;
+                    changed = true;
+
+                    SELF_TEST_LOG("ProcessTimers: war started war_id=" + std::to_string(war.war_id));
+                }
+
+                // Self-test: keep war Active for N seconds, then end and start cooldown.
+                if (Cfg().self_test && war.ended_at == 0 && war.start_notified)
+                {
+                    const auto active_seconds = std::max<int32_t>(1, Cfg().self_test_active_seconds);
+                    if (now >= war.start_at + active_seconds)
+                    {
+                        war.ended_at = now;
+                        war.cooldown_end_a = now + Cfg().cooldown_seconds;
+                        war.cooldown_end_b = now + Cfg().cooldown_seconds;
+                        war.cooldown_notified = false;
+                        changed = true;
+                        SELF_TEST_LOG("ProcessTimers: war ended war_id=" + std::to_string(war.war_id) +
+                                    " cooldown=" + std::to_string(Cfg().cooldown_seconds) + "s");
+                    }
+                }
+
+                if (war.ended_at != 0)
+                {
+                    if (!war.cooldown_notified && now >= war.cooldown_end_a && now >= war.cooldown_end_b)
+                    {
+                        events.push_back(WarEvent{ WarEventType::CooldownEnded, war.tribe_a, war.war_id });
+                        events.push_back(WarEvent{ WarEventType::CooldownEnded, war.tribe_b, war.war_id });
+                        war.cooldown_notified = true;
+                        changed = true;
+
+                        SELF_TEST_LOG("ProcessTimers: cooldown ended war_id=" + std::to_string(war.war_id));
+                    }
+
+                    // War can be cleaned up after both cooldowns ended.
+                    if (war.cooldown_end_a > 0 && war.cooldown_end_b > 0 &&
+                        now >= war.cooldown_end_a && now >= war.cooldown_end_b)
+                    {
+                        war_ids_to_remove.push_back(it.first);
+                    }
+                }
+            }
+
+            if (!war_ids_to_remove.empty())
+            {
+                for (const auto war_id : war_ids_to_remove)
+                    wars_by_id_.erase(war_id);
+
+                RebuildTribeIndexLocked(now);
+                changed = true;
+
+                SELF_TEST_LOG("ProcessTimers: cleaned up wars count=" + std::to_string(war_ids_to_remove.size()));
+            }
+        }
+
+        if (changed)
+            MarkDirty();
+    }
+    catch (...)
+    {
+        timers_enabled_ = false;
+    }
+
+    return events;
+}
+
+void WarEngine::UpdateAbandonedTribes(int64_t now)
+{
+    const int32_t window = (std::max)(0, Cfg().abandoned_structure_window_seconds);
+    if (!Cfg().enable_abandoned_structure_window || window <= 0)
+    {
+        // Switched off by a reload: drop the windows and deadlines the last
+        // sweeps left, so switching it back on starts from a clean table.
+        if (abandoned_tracking_)
+        {
+            DataLockGuard lock(mutex_);
+            abandoned_tracker_.Clear(registry_);
+            abandoned_scan_cursor_ = 0;
+            abandoned_tracking_ = false;
+        }
+        return;
+    }
+
+    if (!world_.IsReady())
+        return;
+
+    try
+    {
+        // Read a batch of member counts without holding the lock, then apply them.
+        const int32_t total = world_.GetTribeCount();
+        const int32_t batch = (std::max)(1, Cfg().abandoned_scan_batch);
+        if (abandoned_scan_cursor_ >= total)
+            abandoned_scan_cursor_ = 0;
+
+        const int32_t end = (std::min)(total, abandoned_scan_cursor_ + batch);
+        std::vector<TribeMembers> observed;
+        observed.reserve(static_cast<size_t>((std::max)(0, end - abandoned_scan_cursor_)));
+        world_.ReadTribeMembers(abandoned_scan_cursor_, end, observed);
+
+        const bool wrapped = end >= total;
+        abandoned_scan_cursor_ = wrapped ? 0 : end;
+
+        DataLockGuard lock(mutex_);
+        abandoned_tracking_ = true;
+        abandoned_tracker_.SetWindow(window);
+        for (const auto& it : observed)
+            abandoned_tracker_.Observe(registry_, it.tribe_id, it.members);
+        if (wrapped)
+            abandoned_tracker_.EndSweep(registry_, now);
+        abandoned_tracker_.Expire(registry_, now);
+    }
+    catch (...)
+    {
+        // ignore
+    }
+}
+
+bool WarEngine::IsAbandonedStructureVulnerable(int64_t target_tribe_id, int64_t now, float& out_multiplier)
+{
+    out_multiplier = 1.0f;
+    const auto& values = Cfg();
+    if (!values.enable_abandoned_structure_window)
+        return false;
+    return IsAbandonedTargetVulnerable(values, target_tribe_id, now, out_multiplier);
+}
+
+bool WarEngine::IsAbandonedTargetVulnerable(const Config& values, int64_t target_tribe_id, int64_t now, float& out_multiplier)
+{
+    target_tribe_id = CanonicalTribeId(target_tribe_id);
+    if (target_tribe_id == 0)
+        return false;
+
+    DataLockGuard lock(mutex_);
+    if (!AbandonedTracker::IsVulnerable(registry_, target_tribe_id, now))
+        return false;
+
+    out_multiplier = values.abandoned_structure_damage_multiplier;
+    return true;
+}
+
+bool WarEngine::IsExcludedStructure(const void* structure_class)
+{
+    const auto& matcher = Snapshot().excluded;
+    if (matcher.Empty())
+        return false;
+    return MatchesExclusion(matcher, structure_class);
+}
+
+bool WarEngine::MatchesExclusion(const StructureExclusionMatcher& matcher, const void* structure_class)
+{
+    if (!structure_class)
+        return false;
+
+    switch (matcher.Lookup(structure_class))
+    {
+    case StructureExclusionMatcher::Memo::Excluded:
+        return true;
+    case StructureExclusionMatcher::Memo::Included:
+        return false;
+    case StructureExclusionMatcher::Memo::Unknown:
+        break;
+    }
+
+    std::string path;
+    if (!world_.TryGetClassPath(structure_class, path))
+        return false;
+    const auto normalized = NormalizeBlueprintPath(path);
+    if (normalized.empty())
+        return false;
+
+    const bool excluded = matcher.MatchesPath(normalized);
+    matcher.Remember(structure_class, excluded);
+    return excluded;
+}
+
+bool WarEngine::IsStructureDamageAllowed(const void* structure_class, int64_t target_tribe, int64_t attacker_tribe, float& out_multiplier)
+{
+    const auto* active = config_.load(std::memory_order_acquire);
+    return (this->*active->damage_policy)(*active->snapshot, structure_class, target_tribe, attacker_tribe, out_multiplier);
+}
+
+template <bool kExclusions, bool kAbandonedWindow>
+bool WarEngine::EvaluateStructureDamage(const ConfigSnapshot& snapshot, const void* structure_class, int64_t target_tribe,
+                                        int64_t attacker_tribe, float& out_multiplier)
+{
+    out_multiplier = 1.0f;
+
+    if (!world_.IsReady())
+        return false;
+
+    if constexpr (kExclusions)
+    {
+        if (MatchesExclusion(snapshot.excluded, structure_class))
+            return true;
+    }
+
+    const auto now = clock_.Now();
+
+    if (target_tribe == 0 || attacker_tribe == 0)
+    {
+        // If attacker has no tribe, only allow against abandoned tribes (optional feature).
+        if constexpr (kAbandonedWindow)
+        {
+            if (target_tribe != 0 && IsAbandonedTargetVulnerable(snapshot.values, target_tribe, now, out_multiplier))
+                return true;
+        }
+        return false;
+    }
+
+    if (target_tribe == attacker_tribe)
+        return true;
+
+    // Abandoned tribe window: structures can be damaged by anyone.
+    if constexpr (kAbandonedWindow)
+    {
+        if (IsAbandonedTargetVulnerable(snapshot.values, target_tribe, now, out_multiplier))
+            return true;
+    }
+
+    return IsOpposingWarSides(snapshot.values, target_tribe, attacker_tribe, now, out_multiplier);
+}
+
+WarEngine::DamagePolicy WarEngine::SelectDamagePolicy(const ConfigSnapshot& snapshot)
+{
+    // [exclusions][abandoned window]
+    static constexpr DamagePolicy kPolicies[2][2] = {
+        { &WarEngine::EvaluateStructureDamage<false, false>, &WarEngine::EvaluateStructureDamage<false, true> },
+        { &WarEngine::EvaluateStructureDamage<true, false>, &WarEngine::EvaluateStructureDamage<true, true> },
+    };
+    return kPolicies[snapshot.excluded.Empty() ? 0 : 1][snapshot.values.enable_abandoned_structure_window ? 1 : 0];
+}
+
+bool WarEngine::IsOpposingWarSides(const Config& values, int64_t target_tribe, int64_t attacker_tribe, int64_t now, float& out_multiplier)
+{
+    if (!HasOpposingSides(target_tribe, attacker_tribe, now))
+        return false;
+    out_multiplier = values.structure_damage_multiplier;
+    return true;
+}
+
+bool WarEngine::HasOpposingSides(int64_t target_tribe, int64_t attacker_tribe, int64_t now)
+{
+    {
+        // Usual case: both tribes were profiled earlier this tick.
+        DataLockGuard lock(mutex_);
+        RefreshWarSidesLocked();
+        if (!war_sides_.HasWars())
+            return false;
+        uint32_t attacker_count = 0;
+        uint32_t target_count = 0;
+        const auto* attacker = war_sides_.Find(attacker_tribe, attacker_count);
+        const auto* target = war_sides_.Find(target_tribe, target_count);
+        if ((attacker && attacker_count == 0) || (target && target_count == 0))
+            return false;
+        if (attacker && target)
+            return HasOpposingActiveWarLocked(attacker, attacker_count, target, target_count, now);
+    }
+
+    thread_local std::vector<SideMembership> attacker_sides;
+    thread_local std::vector<SideMembership> target_sides;
+    GetWarSides(attacker_tribe, attacker_sides);
+    if (attacker_sides.empty())
+        return false;
+    GetWarSides(target_tribe, target_sides);
+    if (target_sides.empty())
+        return false;
+
+    DataLockGuard lock(mutex_);
+    return HasOpposingActiveWarLocked(attacker_sides.data(), attacker_sides.size(), target_sides.data(), target_sides.size(), now);
+}
+
+bool WarEngine::HasOpposingActiveWarLocked(const SideMembership* attacker, size_t attacker_count, const SideMembership* target,
+                                           size_t target_count, int64_t now)
+{
+    for (size_t i = 0; i < attacker_count; ++i)
+    {
+        for (size_t j = 0; j < target_count; ++j)
+        {
+            if (attacker[i].war_id != target[j].war_id)
+                continue;
+            const bool opposing = ((attacker[i].sides & kWarSideA) && (target[j].sides & kWarSideB)) ||
+                                  ((attacker[i].sides & kWarSideB) && (target[j].sides & kWarSideA));
+            if (!opposing)
+                continue;
+            const auto* war = FindWarLocked(attacker[i].war_id);
+            if (war && IsActiveWar(*war, now))
+                return true;
+        }
+    }
+    return false;
+}
+
+void WarEngine::SeedSelfTestWar(int64_t now)
+{
+    if (!Cfg().self_test)
+        return;
+
+    DataLockGuard lock(mutex_);
+    if (!wars_by_id_.empty())
+        return;
+
+    const auto a = Cfg().self_test_tribe_a;
+    const auto b = Cfg().self_test_tribe_b;
+    if (a == 0 || b == 0 || a == b)
+        return;
+
+    WarRecord war;
+    war.war_id = next_war_id_++;
+    war.tribe_a = a;
+    war.tribe_b = b;
+    war.declared_at = now;
+    war.start_at = now + Cfg().war_delay_seconds;
+    wars_by_id_[war.war_id] = war;
+    RebuildTribeIndexLocked(now);
+
+    SELF_TEST_LOG("SeedSelfTestWar: created war_id=" + std::to_string(war.war_id) +
+                " a=" + std::to_string(a) + " b=" + std::to_string(b) +
+                " start_in=" + std::to_string(Cfg().war_delay_seconds) + "s");
+}
+
+bool WarEngine::SaveData(const std::string& path)
+{
+    TraceScope trace("WarEngine::SaveData", "io");
+    try
+    {
+        int64_t snapshot_next_war_id = 1;
+        std::vector<WarRecord> snapshot_wars;
+        {
+            DataLockGuard lock(mutex_);
+            snapshot_next_war_id = next_war_id_;
+            snapshot_wars.reserve(wars_by_id_.size());
+            for (const auto& it : wars_by_id_)
+                snapshot_wars.push_back(it.second);
+        }
+
+        std::filesystem::create_directories(
+            std::filesystem::path(path).parent_path()
+        );
+
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open())
+        {
+            SELF_TEST_LOG("SaveData: failed to open data.json");
+            return false;
+        }
+
+        nlohmann::json json;
+        json["next_war_id"] = snapshot_next_war_id;
+        json["wars"] = nlohmann::json::array();
+
+        for (const auto& war : snapshot_wars)
+        {
+            nlohmann::json item;
+            item["war_id"] = war.war_id;
+            item["tribe_a"] = war.tribe_a;
+            item["tribe_b"] = war.tribe_b;
+            item["declared_at"] = war.declared_at;
+            item["start_at"] = war.start_at;
+            item["ended_at"] = war.ended_at;
+            item["cooldown_end_a"] = war.cooldown_end_a;
+            item["cooldown_end_b"] = war.cooldown_end_b;
+            item["cancel_requested_by_a"] = war.cancel_requested_by_a;
+            item["cancel_requested_by_b"] = war.cancel_requested_by_b;
+            item["start_notified"] = war.start_notified;
+            item["cooldown_notified"] = war.cooldown_notified;
+            json["wars"].push_back(item);
+        }
+
+        file << json.dump(2);
+        SELF_TEST_LOG("SaveData: wrote data.json (wars=" + std::to_string(snapshot_wars.size()) + ")");
+        return true;
+    }
+    catch (...)
+    {
+        // Silent fail to avoid crash
+        SELF_TEST_LOG("SaveData: exception");
+        return false;
+    }
+}
+
+void WarEngine::LoadData(const std::string& path, int64_t now)
+{
+    TraceScope trace("WarEngine::LoadData", "io");
+    try
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.is_open())
+            return;
+
+        const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const auto json = nlohmann::json::parse(content, nullptr, false);
+        if (json.is_discarded())
+            return;
+
+        int64_t loaded_next_war_id = json.value("next_war_id", static_cast<int64_t>(1));
+
+        std::vector<WarRecord> loaded_wars;
+
+        if (json.find("wars") != json.end())
+        {
+            for (const auto& item : json["wars"])
+            {
+                WarRecord war;
+                war.war_id = item.value("war_id", 0);
+                war.tribe_a = CanonicalTribeId(item.value("tribe_a", static_cast<int64_t>(0)));
+                war.tribe_b = CanonicalTribeId(item.value("tribe_b", static_cast<int64_t>(0)));
+                war.declared_at = item.value("declared_at", 0);
+                war.start_at = item.value("start_at", 0);
+                war.ended_at = item.value("ended_at", 0);
+                war.cooldown_end_a = item.value("cooldown_end_a", 0);
+                war.cooldown_end_b = item.value("cooldown_end_b", 0);
+                war.cancel_requested_by_a = item.value("cancel_requested_by_a", false);
+                war.cancel_requested_by_b = item.value("cancel_requested_by_b", false);
+                war.start_notified = item.value("start_notified", false);
+                war.cooldown_notified = item.value("cooldown_notified", false);
+
+                if (war.war_id <= 0)
+                    continue;
+                if (war.tribe_a == 0 || war.tribe_b == 0)
+                    continue;
+                if (IsStaleWarRecord(war, now, Cfg().cooldown_seconds))
+                    continue;
+
+                loaded_wars.push_back(war);
+            }
+        }
+
+        {
+            DataLockGuard lock(mutex_);
+            wars_by_id_.clear();
+            next_war_id_ = loaded_next_war_id;
+            for (const auto& war : loaded_wars)
+                wars_by_id_[war.war_id] = war;
+            RebuildTribeIndexLocked(now);
+        }
+    }
+    catch (...)
+    {
+        DataLockGuard lock(mutex_);
+        wars_by_id_.clear();
+        RebuildTribeIndexLocked(now);
+        next_war_id_ = 1;
+    }
+}
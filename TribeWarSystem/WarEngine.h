@@ -0,0 +1,275 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AbandonedTracker.h"
+#include "Clock.h"
+#include "FlatHashMap.h"
+#include "GameWorld.h"
+#include "Logger.h"
+#include "Sync.h"
+#include "TribeRegistry.h"
+#include "TribeWarConfig.h"
+#include "WarSideCache.h"
+
+struct WarRecord
+{
+    int64_t war_id = 0;
+    int64_t tribe_a = 0;
+    int64_t tribe_b = 0;
+    int64_t declared_at = 0;
+    int64_t start_at = 0;
+    int64_t ended_at = 0;
+    int64_t cooldown_end_a = 0;
+    int64_t cooldown_end_b = 0;
+    bool cancel_requested_by_a = false;
+    bool cancel_requested_by_b = false;
+    bool start_notified = false;
+    bool cooldown_notified = false;
+};
+
+enum class WarPhase
+{
+    None,
+    Pending,
+    Active,
+    Cooldown
+};
+
+struct WarView
+{
+    WarRecord war;
+    int64_t side_root = 0; // war.tribe_a or war.tribe_b that this tribe belongs to (directly or via alliance)
+};
+
+// Why a declaration was refused. The plugin maps these to player messages.
+enum class WarDenyReason
+{
+    None,
+    NoTribe,
+    SameTribe,
+    Allied,
+    AlreadyInWar,
+    TargetOffline,
+    Cooldown
+};
+
+// Timer outcomes, one per side; the plugin turns them into notifications.
+enum class WarEventType
+{
+    Started,
+    CooldownEnded
+};
+
+struct WarEvent
+{
+    WarEventType type = WarEventType::Started;
+    int64_t side_tribe_id = 0;
+    int64_t war_id = 0;
+};
+
+using DataMutex = WinMutex;
+using DataLockGuard = LockGuard<DataMutex>;
+
+int64_t CanonicalTribeId(int64_t raw_id);
+WarPhase GetPhase(const WarRecord& war, int64_t now);
+bool IsActiveWar(const WarRecord& war, int64_t now);
+// Records LoadData drops: ended wars whose cooldowns are over, or implausibly old ones.
+bool IsStaleWarRecord(const WarRecord& war, int64_t now, int32_t cooldown_seconds);
+
+// War state and rules, independent of ArkApi and Windows.
+// Everything the engine needs from the game goes through IGameWorld; time comes
+// from IClock.
+//
+// Thread-safe: public members lock Mutex() themselves, except *Locked ones,
+// which expect the caller to hold it.
+class WarEngine
+{
+public:
+    // `world` and `clock` must outlive the engine. `config` is copied into the
+    // engine's first snapshot; SetConfig replaces it.
+    WarEngine(IGameWorld& world, IClock& clock, const Config& config)
+        : world_(world), clock_(clock)
+    {
+        SetConfig(std::make_shared<const ConfigSnapshot>(config));
+    }
+
+    WarEngine(const WarEngine&) = delete;
+    WarEngine& operator=(const WarEngine&) = delete;
+
+    // Receives self-test diagnostics (only emitted while config.self_test is on).
+    void SetSelfTestLog(LogChannel* log)
+    {
+        self_test_log_ = log;
+    }
+
+    // Swaps in a new configuration and the damage pipeline built for its
+    // feature flags; readers pick both up on their next call without locking.
+    // A call on another thread may still be reading the previous snapshot, so
+    // it is only freed by the BeginTick kConfigGraceTicks ticks later.
+    void SetConfig(std::shared_ptr<const ConfigSnapshot> snapshot);
+
+    // The configuration in effect. One atomic load, no lock.
+    const ConfigSnapshot& Snapshot() const
+    {
+        return *config_.load(std::memory_order_acquire)->snapshot;
+    }
+
+    const Config& Cfg() const
+    {
+        return Snapshot().values;
+    }
+
+    // Guards all engine state. The plugin also keeps its tribe name table under it.
+    DataMutex& Mutex()
+    {
+        return mutex_;
+    }
+
+    TribeRegistry& RegistryLocked()
+    {
+        return registry_;
+    }
+
+    WarRecord* FindWarLocked(int64_t war_id);
+    WarRecord* GetWarForTribeLocked(int64_t tribe_id);
+    void RebuildTribeIndexLocked(int64_t now);
+
+    // Called at the start of every timer tick: alliances are asked again and
+    // snapshots replaced long enough ago are freed.
+    void BeginTick();
+
+    // War the tribe directly takes part in, unless it is already over.
+    std::optional<WarRecord> GetWarForTribe(int64_t tribe_id);
+    // Same, but also finds wars the tribe is part of through an alliance.
+    std::optional<WarView> GetWarForSide(int64_t tribe_id);
+    bool IsTribeInCooldown(int64_t tribe_id, int64_t now);
+    // Tribes at war or in cooldown at `now` (the union of the two checks above).
+    // Returns when the first of them frees up on its own, or INT64_MAX.
+    int64_t CollectBusyTribesLocked(int64_t now, std::vector<int64_t>& out);
+    bool HasIncomingCancel(int64_t tribe_id);
+    bool HasWars();
+    // Copy of the war table, ordered by war ID.
+    std::vector<WarRecord> GetWars();
+
+    // Consistency of the war table and the tribe index; one line per problem.
+    std::vector<std::string> CheckInvariants(int64_t now);
+
+    WarDenyReason CheckWarAllowed(int64_t tribe_a, int64_t tribe_b, int64_t now);
+    WarRecord DeclareWar(int64_t tribe_a, int64_t tribe_b);
+    // Marks the tribe's cancel request. Returns the opponent, or 0 if there is no running war.
+    int64_t RequestCancelWar(int64_t tribe_id);
+    // Ends the war once both sides asked for it; returns the ended war.
+    std::optional<WarRecord> AcceptCancelWar(int64_t tribe_id);
+
+    // Advances war phases; returns what the players should be told.
+    std::vector<WarEvent> ProcessTimers(int64_t now);
+
+    // Scans the next batch of the world's tribe table for empty tribes.
+    void UpdateAbandonedTribes(int64_t now);
+    bool IsAbandonedStructureVulnerable(int64_t target_tribe_id, int64_t now, float& out_multiplier);
+    bool IsExcludedStructure(const void* structure_class);
+
+    // Tribe IDs are canonical, 0 = no tribe. Does not handle a missing structure.
+    // Runs the DamagePolicy SetConfig selected; see EvaluateStructureDamage.
+    bool IsStructureDamageAllowed(const void* structure_class, int64_t target_tribe, int64_t attacker_tribe, float& out_multiplier);
+
+    // Self-test mode: seeds a synthetic war when there are none.
+    void SeedSelfTestWar(int64_t now);
+
+    bool SaveData(const std::string& path);
+    void LoadData(const std::string& path, int64_t now);
+
+    // Set by every state change; the owner saves when it consumes it.
+    void MarkDirty()
+    {
+        war_state_version_.fetch_add(1, std::memory_order_release);
+        dirty_.store(true);
+    }
+
+    // Changes with every war declared, cancelled, started, ended or cleaned up.
+    // Lets the plugin cache anything derived from who is at war.
+    uint64_t WarStateVersion() const
+    {
+        return war_state_version_.load(std::memory_order_acquire);
+    }
+
+    bool ConsumeDirty()
+    {
+        return dirty_.exchange(false);
+    }
+
+private:
+    using DamagePolicy = bool (WarEngine::*)(const ConfigSnapshot&, const void*, int64_t, int64_t, float&);
+
+    // A snapshot and the damage pipeline specialized for it, swapped as one
+    // pointer so the hook never pairs a policy with another config's values.
+    struct ActiveConfig
+    {
+        std::shared_ptr<const ConfigSnapshot> snapshot;
+        DamagePolicy damage_policy = nullptr;
+    };
+
+    // A replaced config, kept until no call can still be using it.
+    struct RetiredConfig
+    {
+        std::unique_ptr<const ActiveConfig> config;
+        uint32_t retired_generation = 0; // alliance_generation_ when replaced
+    };
+
+    // Ticks a replaced config outlives its replacement. Readers never keep a
+    // snapshot past the call (or timer tick) that loaded it.
+    static constexpr uint32_t kConfigGraceTicks = 2;
+
+    // The IsStructureDamageAllowed pipeline: exclusion -> same tribe ->
+    // abandoned window -> war sides. Instantiated once per combination of the
+    // optional stages; a stage switched off in the config is compiled out of
+    // the policy instead of tested on every hit.
+    template <bool kExclusions, bool kAbandonedWindow>
+    bool EvaluateStructureDamage(const ConfigSnapshot& snapshot, const void* structure_class, int64_t target_tribe,
+                                 int64_t attacker_tribe, float& out_multiplier);
+    static DamagePolicy SelectDamagePolicy(const ConfigSnapshot& snapshot);
+
+    // Pipeline stages, without the config flag checks.
+    bool MatchesExclusion(const StructureExclusionMatcher& matcher, const void* structure_class);
+    bool IsAbandonedTargetVulnerable(const Config& values, int64_t target_tribe_id, int64_t now, float& out_multiplier);
+    bool IsOpposingWarSides(const Config& values, int64_t target_tribe, int64_t attacker_tribe, int64_t now, float& out_multiplier);
+    bool HasOpposingSides(int64_t target_tribe, int64_t attacker_tribe, int64_t now);
+
+    // The tribe's war sides this tick (see WarSideCache). Takes mutex_
+    // itself; alliance queries for a new profile run without it.
+    void GetWarSides(int64_t tribe_id, std::vector<SideMembership>& out);
+    void RefreshWarSidesLocked();
+    bool HasOpposingActiveWarLocked(const SideMembership* attacker, size_t attacker_count, const SideMembership* target,
+                                    size_t target_count, int64_t now);
+
+    IGameWorld& world_;
+    IClock& clock_;
+    std::atomic<const ActiveConfig*> config_{ nullptr };
+    std::unique_ptr<const ActiveConfig> active_config_; // owns config_, guarded by mutex_
+    std::vector<RetiredConfig> retired_configs_;       // guarded by mutex_, oldest first
+    LogChannel* self_test_log_ = nullptr;
+
+    DataMutex mutex_{ "data_mutex" };
+    // std::unordered_map on purpose: with WarRecord-sized values it beats
+    // FlatHashMap on inserts and heap at thousands of wars (FlatHashMapBench).
+    std::unordered_map<int64_t, WarRecord> wars_by_id_;
+    TribeRegistry registry_;          // per-tribe war slot, cooldown, abandoned window, name handle
+    uint32_t alliance_generation_ = 1; // bumped every timer tick to refresh war side profiles
+    WarSideCache war_sides_;
+    AbandonedTracker abandoned_tracker_;
+    int64_t next_war_id_ = 1;
+
+    int32_t abandoned_scan_cursor_ = 0; // next tribe table row, timer thread only
+    bool abandoned_tracking_ = false;    // the tracker holds state; timer thread only
+    bool timers_enabled_ = true;        // timer thread only; switched off after an unexpected failure
+    std::atomic<bool> dirty_{ false };
+    std::atomic<uint64_t> war_state_version_{ 1 };
+};
@@ -0,0 +1,37 @@
+#include "WarSideCache.h"
+
+const SideMembership* WarSideCache::Find(int64_t tribe_id, uint32_t& count) const
+{
+    const auto* profile = profiles_.find(tribe_id);
+    if (!profile)
+        return nullptr;
+    count = profile->count;
+    return pool_.data() + profile->begin;
+}
+
+void WarSideCache::Store(int64_t tribe_id, uint64_t epoch, const std::vector<SideMembership>& sides)
+{
+    if (epoch != Epoch() || profiles_.find(tribe_id))
+        return;
+    const auto begin = static_cast<uint32_t>(pool_.size());
+    pool_.insert(pool_.end(), sides.begin(), sides.end());
+    profiles_.insert_or_assign(tribe_id, Profile{ begin, static_cast<uint32_t>(sides.size()) });
+}
+
+void WarSideCache::Collect(IGameWorld& world, const std::vector<WarSideRoots>& roots, int64_t tribe_id,
+                           std::vector<SideMembership>& out)
+{
+    out.clear();
+    if (tribe_id == 0)
+        return;
+    for (const auto& war : roots)
+    {
+        uint8_t sides = 0;
+        if (tribe_id == war.tribe_a || world.AreTribesAllied(tribe_id, war.tribe_a))
+            sides |= kWarSideA;
+        if (tribe_id == war.tribe_b || world.AreTribesAllied(tribe_id, war.tribe_b))
+            sides |= kWarSideB;
+        if (sides != 0)
+            out.push_back(SideMembership{ war.war_id, sides });
+    }
+}
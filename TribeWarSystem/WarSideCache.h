@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "GameWorld.h"
+
+// The two tribes a war was declared between; everyone else joins a side by
+// being allied to one of them.
+struct WarSideRoots
+{
+    int64_t war_id = 0;
+    int64_t tribe_a = 0;
+    int64_t tribe_b = 0;
+};
+
+constexpr uint8_t kWarSideA = 1;
+constexpr uint8_t kWarSideB = 2;
+
+// One war a tribe is on a side of: kWarSideA, kWarSideB, or both when it is
+// allied to both roots.
+struct SideMembership
+{
+    int64_t war_id = 0;
+    uint8_t sides = 0;
+};
+
+// Per-tick profile of which war sides a tribe is on, counting alliances.
+// Building a profile asks the world about every war root once (Collect, done
+// without data_mutex); after that, each damage check between two tribes only
+// compares their two short lists. Profiles are dropped when the tick
+// generation or the war table changes, and tribes in no war get an empty
+// profile, so nothing here depends on the tribe registry.
+//
+// Not thread-safe; callers guard it with data_mutex, except Collect.
+class WarSideCache
+{
+public:
+    using Roots = std::shared_ptr<const std::vector<WarSideRoots>>;
+
+    // Drops stale profiles. `rebuild_roots` is only called when the war table
+    // changed since the last call.
+    template <typename RebuildRoots>
+    void Refresh(uint32_t generation, uint64_t war_version, RebuildRoots&& rebuild_roots)
+    {
+        if (war_version != war_version_ || !roots_)
+        {
+            roots_ = std::make_shared<const std::vector<WarSideRoots>>(rebuild_roots());
+            war_version_ = war_version;
+            ClearProfiles();
+        }
+        if (generation != generation_)
+        {
+            generation_ = generation;
+            ClearProfiles();
+        }
+    }
+
+    const Roots& GetRoots() const
+    {
+        return roots_;
+    }
+
+    bool HasWars() const
+    {
+        return roots_ && !roots_->empty();
+    }
+
+    // Key for Store: the profiles a Collect result may be added to.
+    uint64_t Epoch() const
+    {
+        return (war_version_ << 32) ^ generation_;
+    }
+
+    // Memberships of a profiled tribe, or nullptr. `count` may be 0.
+    const SideMembership* Find(int64_t tribe_id, uint32_t& count) const;
+
+    // Keeps a Collect result if nothing changed since `epoch` was read.
+    void Store(int64_t tribe_id, uint64_t epoch, const std::vector<SideMembership>& sides);
+
+    // Asks the world which war sides `tribe_id` is on. Call without data_mutex.
+    static void Collect(IGameWorld& world, const std::vector<WarSideRoots>& roots, int64_t tribe_id,
+                        std::vector<SideMembership>& out);
+
+    size_t Size() const
+    {
+        return profiles_.size();
+    }
+
+private:
+    struct Profile
+    {
+        uint32_t begin = 0;
+        uint32_t count = 0;
+    };
+
+    void ClearProfiles()
+    {
+        profiles_.clear();
+        pool_.clear();
+    }
+
+    uint32_t generation_ = 0;
+    uint64_t war_version_ = 0;
+    Roots roots_;
+    FlatHashMap<int64_t, Profile> profiles_; // tribe ID -> range of pool_
+    std::vector<SideMembership> pool_;
+};
@@ -0,0 +1,429 @@
+#include "WarSimulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <unordered_set>
+
+#include "Clock.h"
+#include "SimWorld.h"
+#include "WarEngine.h"
+
+namespace
+{
+constexpr size_t kMaxViolations = 20;
+constexpr int32_t kConfigSwapEvery = 500; // ticks between same-value config swaps (reload path)
+
+struct DamageSample
+{
+    const void* structure_class = nullptr;
+    int64_t target = 0;
+    int64_t attacker = 0;
+    bool allowed = false;
+};
+
+bool SameRecord(const WarRecord& a, const WarRecord& b)
+{
+    return a.war_id == b.war_id && a.tribe_a == b.tribe_a && a.tribe_b == b.tribe_b &&
+           a.declared_at == b.declared_at && a.start_at == b.start_at && a.ended_at == b.ended_at &&
+           a.cooldown_end_a == b.cooldown_end_a && a.cooldown_end_b == b.cooldown_end_b &&
+           a.cancel_requested_by_a == b.cancel_requested_by_a && a.cancel_requested_by_b == b.cancel_requested_by_b &&
+           a.start_notified == b.start_notified && a.cooldown_notified == b.cooldown_notified;
+}
+
+class Simulation
+{
+public:
+    Simulation(const Config& config, const SimulationOptions& options, std::string data_path)
+        : config_(config), options_(options), data_path_(std::move(data_path)), rng_(options.seed)
+    {
+        // The simulated engine must not write self-test logs or end wars on its own.
+        config_.self_test = false;
+    }
+
+    SimulationReport Run()
+    {
+        BuildWorld();
+        engine_ = std::make_unique<WarEngine>(world_, clock_, config_);
+
+        for (int32_t tick = 0; tick < options_.ticks; ++tick)
+        {
+            if (options_.cancel && options_.cancel->load())
+                break;
+            tick_ = tick;
+            clock_.Advance((std::max)(1, options_.tick_seconds));
+            ChangeWorld();
+            CheckBusyTribes(); // cooldowns may have run out before ProcessTimers sees them
+            if ((tick + 1) % kConfigSwapEvery == 0)
+                engine_->SetConfig(std::make_shared<const ConfigSnapshot>(config_));
+
+            const auto start = std::chrono::steady_clock::now();
+            engine_->BeginTick();
+            engine_->UpdateAbandonedTribes(clock_.Now());
+            for (const auto& event : engine_->ProcessTimers(clock_.Now()))
+            {
+                if (event.type == WarEventType::Started)
+                    ++report_.started;
+                else
+                    ++report_.cooldowns_ended;
+            }
+            DeclareWars();
+            DriveCancels();
+            InjectDamage();
+            report_.tick_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            ++report_.ticks;
+
+            CheckDamage();
+            CheckBusyTribes();
+            for (const auto& problem : engine_->CheckInvariants(clock_.Now()))
+                Violation(problem);
+
+            if (options_.restart_every > 0 && (tick + 1) % options_.restart_every == 0)
+                Restart();
+        }
+
+        // Both events are reported once per side.
+        report_.started /= 2;
+        report_.cooldowns_ended /= 2;
+        return std::move(report_);
+    }
+
+private:
+    void Violation(const std::string& message)
+    {
+        ++report_.violation_count;
+        if (report_.violations.size() < kMaxViolations)
+            report_.violations.push_back("tick " + std::to_string(tick_) + ": " + message);
+    }
+
+    int64_t AnyTribe()
+    {
+        return tribe_ids_[rng_() % tribe_ids_.size()];
+    }
+
+    bool Chance(uint32_t one_in)
+    {
+        return one_in <= 1 || rng_() % one_in == 0;
+    }
+
+    void BuildWorld()
+    {
+        const size_t tribes = static_cast<size_t>((std::max)(4, options_.tribes));
+        tribe_ids_.reserve(tribes);
+        members_.reserve(tribes);
+        in_table_.assign(tribes, true);
+        for (size_t i = 0; i < tribes; ++i)
+        {
+            int64_t id = 0;
+            do
+                id = static_cast<int64_t>(1000000000u + static_cast<uint32_t>(rng_() % 1000000000u));
+            while (std::find(tribe_ids_.begin(), tribe_ids_.end(), id) != tribe_ids_.end());
+            tribe_ids_.push_back(id);
+            members_.push_back(static_cast<int32_t>(1 + rng_() % 6));
+            if (!Chance(5))
+                world_.online.insert(id);
+        }
+        for (size_t i = 0; i < tribes / 10; ++i)
+            world_.Ally(AnyTribe(), AnyTribe());
+
+        // Class 0 matches the configured exclusion list (when there is one).
+        const std::string excluded = config_.excluded_structure_blueprints.empty() ? std::string("/game/none/excluded_c")
+                                                                                   : config_.excluded_structure_blueprints.front();
+        world_.class_paths[&classes_[0]] = "Blueprint'" + excluded + "'";
+        world_.class_paths[&classes_[1]] = "Blueprint'/Game/PrimalEarth/Structures/Wooden/Wall_Wood.Wall_Wood_C'";
+        world_.class_paths[&classes_[2]] = "Blueprint'/Game/PrimalEarth/Structures/Stone/Wall_Stone.Wall_Stone_C'";
+        world_.class_paths[&classes_[3]] = "Blueprint'/Game/PrimalEarth/Structures/Metal/Wall_Metal.Wall_Metal_C'";
+        SyncTribeTable();
+    }
+
+    void SyncTribeTable()
+    {
+        world_.tribes.clear();
+        for (size_t i = 0; i < tribe_ids_.size(); ++i)
+        {
+            if (in_table_[i])
+                world_.tribes.push_back(TribeMembers{ tribe_ids_[i], members_[i] });
+        }
+    }
+
+    // Membership churn, tribes leaving and rejoining the table, alliances and logins.
+    void ChangeWorld()
+    {
+        const size_t changes = tribe_ids_.size() / 50 + 1;
+        for (size_t c = 0; c < changes; ++c)
+        {
+            const size_t i = rng_() % tribe_ids_.size();
+            if (!in_table_[i])
+            {
+                in_table_[i] = true;
+                members_[i] = static_cast<int32_t>(1 + rng_() % 6);
+            }
+            else if (members_[i] == 0 && Chance(3))
+                in_table_[i] = false; // tribe deleted
+            else
+                members_[i] = Chance(4) ? 0 : static_cast<int32_t>(1 + rng_() % 6);
+        }
+        SyncTribeTable();
+
+        const int64_t a = AnyTribe();
+        const int64_t b = AnyTribe();
+        if (a != b)
+        {
+            if (world_.alliances.count(SimWorld::AllianceKey(a, b)))
+                world_.Unally(a, b);
+            else
+                world_.Ally(a, b);
+        }
+
+        const int64_t login = AnyTribe();
+        if (world_.online.count(login))
+            world_.online.erase(login);
+        else
+            world_.online.insert(login);
+    }
+
+    void DeclareWars()
+    {
+        int32_t running = 0;
+        for (const auto& war : engine_->GetWars())
+        {
+            if (war.ended_at == 0)
+                ++running;
+        }
+
+        const int32_t wanted = options_.wars - running;
+        for (int32_t attempt = 0; attempt < wanted * 4 && running < options_.wars; ++attempt)
+        {
+            const int64_t a = AnyTribe();
+            const int64_t b = AnyTribe();
+            if (engine_->CheckWarAllowed(a, b, clock_.Now()) != WarDenyReason::None)
+                continue;
+            const auto war = engine_->DeclareWar(a, b);
+            if (war.start_at != war.declared_at + config_.war_delay_seconds)
+                Violation("war " + std::to_string(war.war_id) + " declared with a wrong start time");
+            ++report_.declared;
+            ++running;
+        }
+    }
+
+    void DriveCancels()
+    {
+        for (const auto& war : engine_->GetWars())
+        {
+            if (war.ended_at != 0)
+                continue;
+
+            if (war.cancel_requested_by_a || war.cancel_requested_by_b)
+            {
+                if (!Chance(2))
+                    continue;
+                const int64_t accepting = war.cancel_requested_by_a ? war.tribe_b : war.tribe_a;
+                if (!engine_->HasIncomingCancel(accepting))
+                    Violation("war " + std::to_string(war.war_id) + " cancel request not visible to the other side");
+                if (engine_->AcceptCancelWar(accepting))
+                    ++report_.canceled;
+                else
+                    Violation("war " + std::to_string(war.war_id) + " accept did not end it");
+                continue;
+            }
+
+            if (Chance(40))
+            {
+                const int64_t requesting = Chance(2) ? war.tribe_a : war.tribe_b;
+                if (engine_->RequestCancelWar(requesting) == 0)
+                    Violation("war " + std::to_string(war.war_id) + " rejected a cancel request");
+                ++report_.cancel_requests;
+            }
+        }
+    }
+
+    void InjectDamage()
+    {
+        const auto wars = engine_->GetWars();
+        damage_.clear();
+        for (int32_t i = 0; i < options_.damage_per_tick; ++i)
+        {
+            DamageSample sample;
+            sample.structure_class = &classes_[Chance(10) ? 0 : 1 + rng_() % 3];
+            const auto roll = rng_() % 10;
+            if (roll < 5 && !wars.empty())
+            {
+                const auto& war = wars[rng_() % wars.size()];
+                sample.attacker = Chance(2) ? war.tribe_a : war.tribe_b;
+                sample.target = sample.attacker == war.tribe_a ? war.tribe_b : war.tribe_a;
+            }
+            else
+            {
+                sample.attacker = roll == 9 ? 0 : AnyTribe();
+                sample.target = AnyTribe();
+            }
+
+            float mult = 1.0f;
+            sample.allowed = engine_->IsStructureDamageAllowed(sample.structure_class, sample.target, sample.attacker, mult);
+            damage_.push_back(sample);
+        }
+        report_.damage_calls += static_cast<int64_t>(damage_.size());
+    }
+
+    // Brute force over the war table and the world's alliances, without memos or indexes.
+    void CheckDamage()
+    {
+        const auto wars = engine_->GetWars();
+        const auto allied = [&](int64_t a, int64_t b) {
+            return a == b || world_.alliances.count(SimWorld::AllianceKey(a, b)) != 0;
+        };
+
+        for (const auto& sample : damage_)
+        {
+            bool expected = false;
+            float abandoned_mult = 1.0f;
+            const bool abandoned = engine_->IsAbandonedStructureVulnerable(sample.target, clock_.Now(), abandoned_mult);
+            if (sample.structure_class == &classes_[0] && !config_.excluded_structure_blueprints.empty())
+                expected = true;
+            else if (sample.target == 0 || sample.attacker == 0)
+                expected = sample.target != 0 && abandoned;
+            else if (sample.target == sample.attacker || abandoned)
+                expected = true;
+            else
+            {
+                for (const auto& war : wars)
+                {
+                    if (!IsActiveWar(war, clock_.Now()))
+                        continue;
+                    const bool attacker_a = allied(sample.attacker, war.tribe_a);
+                    const bool attacker_b = allied(sample.attacker, war.tribe_b);
+                    const bool target_a = allied(sample.target, war.tribe_a);
+                    const bool target_b = allied(sample.target, war.tribe_b);
+                    if ((attacker_a && target_b) || (attacker_b && target_a))
+                    {
+                        expected = true;
+                        break;
+                    }
+                }
+            }
+
+            report_.damage_allowed += sample.allowed ? 1 : 0;
+            if (sample.allowed != expected)
+                Violation("damage " + std::to_string(sample.attacker) + " -> " + std::to_string(sample.target) +
+                          (sample.allowed ? " allowed" : " blocked") + ", expected the opposite");
+        }
+    }
+
+    // Keeps a busy-tribe set the way the plugin's declare target cache does
+    // (refreshed on a new WarStateVersion or when it runs out) and checks it
+    // against the per-tribe queries.
+    void CheckBusyTribes()
+    {
+        const auto now = clock_.Now();
+        const auto version = engine_->WarStateVersion();
+        if (busy_version_ != version || now >= busy_valid_until_)
+        {
+            std::vector<int64_t> busy;
+            {
+                DataLockGuard lock(engine_->Mutex());
+                busy_valid_until_ = engine_->CollectBusyTribesLocked(now, busy);
+            }
+            busy_.clear();
+            busy_.insert(busy.begin(), busy.end());
+            busy_version_ = version;
+        }
+
+        for (const auto tribe_id : tribe_ids_)
+        {
+            const bool expected = engine_->GetWarForTribe(tribe_id).has_value() || engine_->IsTribeInCooldown(tribe_id, now);
+            if ((busy_.count(tribe_id) != 0) != expected)
+                Violation("busy cache: tribe " + std::to_string(tribe_id) + (expected ? " missing" : " stale"));
+        }
+    }
+
+    void Restart()
+    {
+        std::vector<WarRecord> before;
+        for (const auto& war : engine_->GetWars())
+        {
+            if (!IsStaleWarRecord(war, clock_.Now(), config_.cooldown_seconds))
+                before.push_back(war);
+        }
+
+        if (!engine_->SaveData(data_path_))
+        {
+            Violation("restart: SaveData failed for " + data_path_);
+            return;
+        }
+        engine_ = std::make_unique<WarEngine>(world_, clock_, config_);
+        engine_->LoadData(data_path_, clock_.Now());
+        ++report_.restarts;
+
+        const auto after = engine_->GetWars();
+        if (after.size() != before.size())
+            Violation("restart: " + std::to_string(before.size()) + " wars saved, " + std::to_string(after.size()) + " loaded");
+        for (size_t i = 0; i < (std::min)(before.size(), after.size()); ++i)
+        {
+            if (!SameRecord(before[i], after[i]))
+                Violation("restart: war " + std::to_string(before[i].war_id) + " changed across save/load");
+        }
+        for (const auto& problem : engine_->CheckInvariants(clock_.Now()))
+            Violation("after restart: " + problem);
+    }
+
+    Config config_;
+    SimulationOptions options_;
+    std::string data_path_;
+    std::mt19937_64 rng_;
+
+    SimWorld world_;
+    ManualClock clock_;
+    std::unique_ptr<WarEngine> engine_;
+    std::unordered_set<int64_t> busy_; // see CheckBusyTribes
+    uint64_t busy_version_ = 0;
+    int64_t busy_valid_until_ = 0;
+    std::vector<int64_t> tribe_ids_;
+    std::vector<int32_t> members_;
+    std::vector<bool> in_table_;
+    int classes_[4] = {}; // addresses are the opaque class handles
+    std::vector<DamageSample> damage_;
+
+    int32_t tick_ = 0;
+    SimulationReport report_;
+};
+}
+
+double SimulationReport::TickPercentile(double p) const
+{
+    if (tick_us.empty())
+        return 0.0;
+    auto sorted = tick_us;
+    const size_t index = (std::min)(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())));
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+    return sorted[index];
+}
+
+std::string SimulationReport::Summary() const
+{
+    char buffer[512];
+    std::snprintf(buffer, sizeof(buffer),
+        "ticks=%lld declared=%lld started=%lld cancel_requests=%lld canceled=%lld cooldowns_ended=%lld restarts=%lld "
+        "damage=%lld/%lld violations=%lld tick_us p50=%.1f p99=%.1f max=%.1f",
+        static_cast<long long>(ticks), static_cast<long long>(declared), static_cast<long long>(started),
+        static_cast<long long>(cancel_requests), static_cast<long long>(canceled), static_cast<long long>(cooldowns_ended),
+        static_cast<long long>(restarts), static_cast<long long>(damage_allowed), static_cast<long long>(damage_calls),
+        static_cast<long long>(violation_count), TickPercentile(0.50), TickPercentile(0.99), TickPercentile(1.0));
+    return buffer;
+}
+
+SimulationReport RunWarSimulation(const Config& config, const SimulationOptions& options, const std::string& data_path)
+{
+    try
+    {
+        return Simulation(config, options, data_path).Run();
+    }
+    catch (const std::exception& e)
+    {
+        SimulationReport report;
+        report.violation_count = 1;
+        report.violations.push_back(std::string("exception: ") + e.what());
+        return report;
+    }
+}
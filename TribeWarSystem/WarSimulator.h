@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TribeWarConfig.h"
+
+// Deterministic war-lifecycle load test. Seeds tribes and alliances on a
+// SimWorld and drives a private WarEngine through a ManualClock: wars are
+// declared, start, get cancelled and cool down; tribes empty out and leave the
+// table; alliances change; structure damage is injected and checked against a
+// brute-force evaluation of the war table; the engine is restarted through
+// SaveData/LoadData. Engine invariants are asserted after every tick.
+//
+// Same config + options => same run. Never touches the live war state.
+struct SimulationOptions
+{
+    uint64_t seed = 1;
+    int32_t tribes = 200;
+    int32_t wars = 40;            // wars kept declared or running at the same time
+    int32_t ticks = 2000;
+    int32_t tick_seconds = 600;   // virtual time per tick
+    int32_t damage_per_tick = 200;
+    int32_t restart_every = 250;  // ticks between save/load restarts, 0 = never
+    const std::atomic<bool>* cancel = nullptr; // checked once per tick
+};
+
+struct SimulationReport
+{
+    int64_t ticks = 0;
+    int64_t declared = 0;
+    int64_t started = 0;
+    int64_t cancel_requests = 0;
+    int64_t canceled = 0;
+    int64_t cooldowns_ended = 0;
+    int64_t restarts = 0;
+    int64_t damage_calls = 0;
+    int64_t damage_allowed = 0;
+
+    int64_t violation_count = 0;
+    std::vector<std::string> violations; // the first few, "tick N: ..."
+    std::vector<double> tick_us;         // engine time per tick
+
+    double TickPercentile(double p) const;
+    std::string Summary() const;
+};
+
+// `data_path` is the scratch file used for restarts.
+SimulationReport RunWarSimulation(const Config& config, const SimulationOptions& options, const std::string& data_path);
@@ -0,0 +1,340 @@
+// Per-call cost of WarEngine::IsStructureDamageAllowed, the body of the
+// APrimalStructure_TakeDamage hook.
+//
+// Each scenario builds a SimWorld server (war count x alliance density) and
+// replays a seeded damage stream: opposing war sides, random pairs, own
+// structures, tribeless attackers, excluded classes and abandoned targets.
+// Every call is measured individually; the report gives percentiles of
+// ns/call, heap allocations/call and mutex acquisitions/call. Lock counts need
+// the core built with TRIBEWAR_LOCK_STATS (the CMake default).
+//
+// Usage: DamageBench [calls_per_scenario] [seed] [max_wars]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "SimWorld.h"
+#include "WarEngine.h"
+
+namespace
+{
+uint64_t allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Alliance timer tick: the plugin's timer runs once a second while damage
+// arrives continuously, so the alliance memo is refreshed every N calls.
+constexpr size_t kCallsPerTick = 256;
+// Scenarios stop early once they used this much wall time (but not before kMinCalls).
+constexpr double kScenarioBudgetSeconds = 3.0;
+constexpr size_t kMinCalls = 16;
+
+struct Scenario
+{
+    size_t wars = 0;
+    int alliance_size = 1; // tribes per alliance group, 1 = no alliances
+    const char* alliance_name = "none";
+};
+
+struct DamageCall
+{
+    const void* structure_class = nullptr;
+    int64_t target = 0;
+    int64_t attacker = 0;
+};
+
+struct Sample
+{
+    std::vector<double> ns;
+    std::vector<uint64_t> allocs;
+    std::vector<uint64_t> locks;
+};
+
+template <typename T>
+T Percentile(std::vector<T> values, double p)
+{
+    if (values.empty())
+        return T();
+    const size_t index = (std::min)(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+template <typename T>
+double Mean(const std::vector<T>& values)
+{
+    double sum = 0.0;
+    for (const auto v : values)
+        sum += static_cast<double>(v);
+    return values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+}
+
+class Server
+{
+public:
+    Config config;
+    SimWorld world;
+    ManualClock clock;
+    std::vector<int64_t> tribe_ids;
+    std::vector<std::pair<int64_t, int64_t>> war_sides; // (tribe_a, tribe_b) per war
+    std::vector<int64_t> abandoned;
+    std::vector<int> classes; // addresses are the opaque class handles
+    size_t excluded_classes = 0;
+
+    void Build(const Scenario& scenario, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        config.war_delay_seconds = 60;
+        config.cooldown_seconds = 600;
+        config.structure_damage_multiplier = 0.5f;
+        config.enable_abandoned_structure_window = true;
+        config.abandoned_structure_window_seconds = 3600;
+        config.abandoned_structure_damage_multiplier = 2.0f;
+        config.excluded_structure_blueprints = {
+            "/game/mods/simplespawners/resourcespawns/rocks/ss_saltresource.ss_saltresource_c",
+            "/game/mods/simplespawners/resourcespawns/trees/ss_aberranttreeresource.ss_aberranttreeresource_c",
+            "/game/extinction/structures/itemballoon/storagebox_balloon.storagebox_balloon_c",
+        };
+
+        const size_t tribes = (std::max)(size_t(2000), scenario.wars * 2 + 1000);
+        tribe_ids.reserve(tribes);
+        for (size_t i = 0; i < tribes; ++i)
+        {
+            const int64_t id = static_cast<int64_t>(1000000000u + static_cast<uint32_t>(rng() % 1000000000u));
+            tribe_ids.push_back(id);
+            const bool empty = rng() % 40 == 0;
+            world.tribes.push_back(TribeMembers{ id, empty ? 0 : static_cast<int32_t>(1 + rng() % 8) });
+            if (empty)
+                abandoned.push_back(id);
+            world.online.insert(id);
+        }
+
+        // Alliance groups of consecutive tribes, every pair inside a group allied.
+        for (size_t group = 0; group + 1 < tribes; group += static_cast<size_t>(scenario.alliance_size))
+        {
+            const size_t end = (std::min)(tribes, group + static_cast<size_t>(scenario.alliance_size));
+            for (size_t i = group; i < end; ++i)
+            {
+                for (size_t j = i + 1; j < end; ++j)
+                    world.Ally(tribe_ids[i], tribe_ids[j]);
+            }
+        }
+
+        // A handful of class handles; the first few match the exclusion list.
+        const char* paths[] = {
+            "Blueprint'/Game/Mods/SimpleSpawners/ResourceSpawns/Rocks/SS_SaltResource.SS_SaltResource_C'",
+            "Blueprint'/Game/Extinction/Structures/ItemBalloon/StorageBox_Balloon.StorageBox_Balloon_C'",
+            "Blueprint'/Game/PrimalEarth/Structures/Wooden/Wall_Wood.Wall_Wood_C'",
+            "Blueprint'/Game/PrimalEarth/Structures/Stone/Wall_Stone.Wall_Stone_C'",
+            "Blueprint'/Game/PrimalEarth/Structures/Metal/Wall_Metal.Wall_Metal_C'",
+            "Blueprint'/Game/PrimalEarth/Structures/Metal/Foundation_Metal.Foundation_Metal_C'",
+            "Blueprint'/Game/PrimalEarth/Structures/Tek/Wall_Tek.Wall_Tek_C'",
+            "Blueprint'/Game/PrimalEarth/Structures/StorageBox_Huge.StorageBox_Huge_C'",
+        };
+        excluded_classes = 2;
+        classes.resize(sizeof(paths) / sizeof(paths[0]));
+        for (size_t i = 0; i < classes.size(); ++i)
+            world.class_paths[&classes[i]] = paths[i];
+    }
+
+    // Declares wars between random tribe pairs the engine accepts and moves them to Active.
+    void StartWars(WarEngine& engine, size_t wars, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        size_t attempts = 0;
+        while (war_sides.size() < wars && attempts < wars * 20)
+        {
+            ++attempts;
+            const int64_t a = tribe_ids[rng() % tribe_ids.size()];
+            const int64_t b = tribe_ids[rng() % tribe_ids.size()];
+            if (engine.CheckWarAllowed(a, b, clock.Now()) != WarDenyReason::None)
+                continue;
+            engine.DeclareWar(a, b);
+            war_sides.emplace_back(a, b);
+        }
+
+        clock.Advance(config.war_delay_seconds);
+        engine.ProcessTimers(clock.Now());
+
+        // Full abandoned-tribe sweep so empty tribes are tracked.
+        const int32_t batches = (world.GetTribeCount() + config.abandoned_scan_batch - 1) / config.abandoned_scan_batch;
+        for (int32_t i = 0; i <= batches; ++i)
+            engine.UpdateAbandonedTribes(clock.Now());
+    }
+
+    std::vector<DamageCall> MakeStream(size_t calls, uint64_t seed) const
+    {
+        std::mt19937_64 rng(seed);
+        const auto any_tribe = [&]() { return tribe_ids[rng() % tribe_ids.size()]; };
+        const auto any_class = [&]() { return static_cast<const void*>(&classes[excluded_classes + rng() % (classes.size() - excluded_classes)]); };
+
+        std::vector<DamageCall> stream;
+        stream.reserve(calls);
+        for (size_t i = 0; i < calls; ++i)
+        {
+            DamageCall call;
+            call.structure_class = any_class();
+            const auto roll = rng() % 100;
+            if (roll < 40 && !war_sides.empty())
+            {
+                // Raid between opposing sides.
+                const auto& war = war_sides[rng() % war_sides.size()];
+                const bool flip = rng() % 2 == 0;
+                call.attacker = flip ? war.first : war.second;
+                call.target = flip ? war.second : war.first;
+            }
+            else if (roll < 70)
+            {
+                call.attacker = any_tribe();
+                call.target = any_tribe();
+            }
+            else if (roll < 80)
+            {
+                call.target = any_tribe();
+                call.attacker = call.target; // own structure
+            }
+            else if (roll < 88)
+            {
+                call.target = any_tribe();
+                call.attacker = 0; // wild creature / tribeless player
+            }
+            else if (roll < 95 && !abandoned.empty())
+            {
+                call.target = abandoned[rng() % abandoned.size()];
+                call.attacker = rng() % 2 == 0 ? 0 : any_tribe();
+            }
+            else
+            {
+                call.structure_class = &classes[rng() % excluded_classes];
+                call.target = any_tribe();
+                call.attacker = any_tribe();
+            }
+            stream.push_back(call);
+        }
+        return stream;
+    }
+};
+
+void RunScenario(const Scenario& scenario, size_t calls, uint64_t seed)
+{
+    Server server;
+    server.Build(scenario, seed);
+    WarEngine engine(server.world, server.clock, server.config);
+    server.StartWars(engine, scenario.wars, seed + 1);
+    const auto stream = server.MakeStream(calls, seed + 2);
+
+    Sample sample;
+    sample.ns.reserve(calls);
+    sample.allocs.reserve(calls);
+    sample.locks.reserve(calls);
+
+    size_t allowed = 0;
+    const auto scenario_start = Clock::now();
+    for (size_t i = 0; i < stream.size(); ++i)
+    {
+        if (i >= kMinCalls && std::chrono::duration<double>(Clock::now() - scenario_start).count() > kScenarioBudgetSeconds)
+            break;
+        if (i % kCallsPerTick == 0)
+            engine.BeginTick();
+
+        const auto& call = stream[i];
+        float mult = 1.0f;
+        const uint64_t allocs_before = allocations;
+#ifdef TRIBEWAR_LOCK_STATS
+        const uint64_t locks_before = lock_acquisitions;
+#endif
+        const auto start = Clock::now();
+        const bool ok = engine.IsStructureDamageAllowed(call.structure_class, call.target, call.attacker, mult);
+        const auto end = Clock::now();
+        sample.ns.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        sample.allocs.push_back(allocations - allocs_before);
+#ifdef TRIBEWAR_LOCK_STATS
+        sample.locks.push_back(lock_acquisitions - locks_before);
+#endif
+        allowed += ok ? 1 : 0;
+    }
+
+    std::printf("%6zu %-6s %8zu | %8.0f %8.0f %9.0f %10.0f | %6.2f %4llu %4llu |",
+        server.war_sides.size(), scenario.alliance_name, sample.ns.size(),
+        Percentile(sample.ns, 0.50), Percentile(sample.ns, 0.90), Percentile(sample.ns, 0.99),
+        *std::max_element(sample.ns.begin(), sample.ns.end()),
+        Mean(sample.allocs),
+        static_cast<unsigned long long>(Percentile(sample.allocs, 0.50)),
+        static_cast<unsigned long long>(Percentile(sample.allocs, 0.99)));
+    if (sample.locks.empty())
+        std::printf("    n/a");
+    else
+        std::printf(" %6.2f %4llu %4llu", Mean(sample.locks),
+            static_cast<unsigned long long>(Percentile(sample.locks, 0.50)),
+            static_cast<unsigned long long>(Percentile(sample.locks, 0.99)));
+    std::printf(" | %5.1f%%\n", 100.0 * static_cast<double>(allowed) / static_cast<double>((std::max)(size_t(1), sample.ns.size())));
+}
+}
+
+int main(int argc, char** argv)
+{
+    const size_t calls = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 20000;
+    const uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 42;
+    const size_t max_wars = argc > 3 ? static_cast<size_t>(std::max(0, std::atoi(argv[3]))) : 10000;
+
+    std::printf("calls/scenario=%zu seed=%llu tick every %zu calls\n", calls, static_cast<unsigned long long>(seed), kCallsPerTick);
+    std::printf("%6s %-6s %8s | %8s %8s %9s %10s | %6s %4s %4s | %6s %4s %4s | %6s\n",
+        "wars", "ally", "calls", "p50 ns", "p90 ns", "p99 ns", "max ns",
+        "alloc", "p50", "p99", "locks", "p50", "p99", "allow");
+
+    const Scenario alliances[] = { { 0, 1, "none" }, { 0, 2, "pairs" }, { 0, 8, "groups" } };
+    for (const size_t wars : { 0, 10, 100, 1000, 10000 })
+    {
+        if (wars > max_wars)
+            continue;
+        for (auto scenario : alliances)
+        {
+            scenario.wars = wars;
+            RunScenario(scenario, calls, seed);
+        }
+    }
+    return 0;
+}
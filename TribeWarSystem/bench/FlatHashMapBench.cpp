@@ -0,0 +1,190 @@
+// FlatHashMap vs std::unordered_map for the plugin's war/tribe tables.
+//
+// Measures insert, lookup (hit and miss) and erase throughput plus heap footprint
+// at table sizes seen on live servers. Keys follow the plugin's shapes: sequential
+// war IDs and sparse 32-bit tribe IDs.
+//
+// Usage: FlatHashMapBench [iterations_per_size]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "FlatHashMap.h"
+
+namespace
+{
+size_t counted_bytes = 0;
+
+template <typename T>
+struct CountingAllocator
+{
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        counted_bytes += n * sizeof(T);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        counted_bytes -= n * sizeof(T);
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+
+// Same size as WarRecord (the wars_by_id value type).
+struct WarLike
+{
+    int64_t fields[8] = {};
+    bool flags[4] = {};
+};
+
+template <typename V>
+using StdMap = std::unordered_map<int64_t, V, std::hash<int64_t>, std::equal_to<int64_t>,
+    CountingAllocator<std::pair<const int64_t, V>>>;
+
+using Clock = std::chrono::steady_clock;
+
+double NsPerOp(Clock::time_point start, Clock::time_point end, size_t ops)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops);
+}
+
+std::vector<int64_t> MakeKeys(size_t n, bool sequential, uint64_t seed)
+{
+    std::vector<int64_t> keys;
+    keys.reserve(n);
+    std::mt19937_64 rng(seed);
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(sequential ? static_cast<int64_t>(i + 1) : static_cast<int64_t>(static_cast<uint32_t>(rng())));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), rng);
+    return keys;
+}
+
+struct Result
+{
+    double insert_ns = 0;
+    double hit_ns = 0;
+    double miss_ns = 0;
+    double erase_ns = 0;
+    size_t bytes = 0;
+};
+
+volatile int64_t sink = 0;
+
+template <typename Map, typename V, typename Find>
+Result Run(const std::vector<int64_t>& keys, const std::vector<int64_t>& misses, int iterations, Find find)
+{
+    Result best;
+    best.insert_ns = best.hit_ns = best.miss_ns = best.erase_ns = 1e30;
+
+    for (int iter = 0; iter < iterations; ++iter)
+    {
+        counted_bytes = 0;
+        Map map;
+
+        auto t0 = Clock::now();
+        for (const auto key : keys)
+            map[key] = V();
+        auto t1 = Clock::now();
+        best.insert_ns = std::min(best.insert_ns, NsPerOp(t0, t1, keys.size()));
+        best.bytes = std::max(best.bytes, counted_bytes);
+
+        int64_t found = 0;
+        t0 = Clock::now();
+        for (int rep = 0; rep < 4; ++rep)
+        {
+            for (const auto key : keys)
+                found += find(map, key) ? 1 : 0;
+        }
+        t1 = Clock::now();
+        best.hit_ns = std::min(best.hit_ns, NsPerOp(t0, t1, keys.size() * 4));
+
+        t0 = Clock::now();
+        for (const auto key : misses)
+            found += find(map, key) ? 1 : 0;
+        t1 = Clock::now();
+        best.miss_ns = std::min(best.miss_ns, NsPerOp(t0, t1, misses.size()));
+
+        t0 = Clock::now();
+        for (const auto key : keys)
+            map.erase(key);
+        t1 = Clock::now();
+        best.erase_ns = std::min(best.erase_ns, NsPerOp(t0, t1, keys.size()));
+
+        sink = sink + found;
+    }
+    return best;
+}
+
+template <typename V>
+void RunSize(const char* label, size_t n, bool sequential, int iterations)
+{
+    const auto keys = MakeKeys(n, sequential, 1234 + n);
+    std::vector<int64_t> misses;
+    misses.reserve(keys.size());
+    for (const auto key : keys)
+        misses.push_back(key + (static_cast<int64_t>(1) << 40));
+
+    const auto flat = Run<FlatHashMap<int64_t, V>, V>(keys, misses, iterations,
+        [](FlatHashMap<int64_t, V>& map, int64_t key) { return map.find(key) != nullptr; });
+    const auto std_map = Run<StdMap<V>, V>(keys, misses, iterations,
+        [](StdMap<V>& map, int64_t key) { return map.find(key) != map.end(); });
+
+    // FlatHashMap allocates through std::vector with the default allocator; size it directly.
+    FlatHashMap<int64_t, V> sized;
+    for (const auto key : keys)
+        sized[key] = V();
+    const size_t flat_bytes = sized.memory_bytes();
+
+    std::printf("%-14s %8zu | %-13s %7.1f %7.1f %7.1f %7.1f %10zu\n", label, keys.size(), "flat",
+        flat.insert_ns, flat.hit_ns, flat.miss_ns, flat.erase_ns, flat_bytes);
+    std::printf("%-14s %8zu | %-13s %7.1f %7.1f %7.1f %7.1f %10zu\n", label, keys.size(), "unordered_map",
+        std_map.insert_ns, std_map.hit_ns, std_map.miss_ns, std_map.erase_ns, std_map.bytes);
+}
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+    std::printf("%-14s %8s | %-13s %7s %7s %7s %7s %10s\n", "table", "entries", "map",
+        "ins ns", "hit ns", "miss ns", "era ns", "bytes");
+
+    // wars_by_id: sequential war IDs, WarRecord-sized values.
+    for (const size_t n : { 16, 256, 4096, 10000 })
+        RunSize<WarLike>("wars_by_id", n, true, iterations);
+
+    // Per-tribe tables: sparse 32-bit tribe IDs, small values.
+    for (const size_t n : { 256, 4096, 20000, 100000 })
+        RunSize<int64_t>("tribe_index", n, false, iterations);
+
+    return 0;
+}
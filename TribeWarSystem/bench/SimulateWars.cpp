@@ -0,0 +1,61 @@
+// Headless run of the war-lifecycle simulator (WarSimulator.h).
+//
+// Point it at a candidate config.json before deploying it: the run uses the
+// same rules the plugin would, prints the report and per-tick engine time,
+// and exits non-zero if any invariant was violated (2 if the file does not
+// parse). Values the plugin would clamp are clamped here too and listed.
+//
+// Usage: SimulateWars [seed] [tribes] [wars] [ticks] [config.json]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include "TribeWarConfig.h"
+#include "WarSimulator.h"
+
+int main(int argc, char** argv)
+{
+    SimulationOptions options;
+    if (argc > 1)
+        options.seed = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 2)
+        options.tribes = std::atoi(argv[2]);
+    if (argc > 3)
+        options.wars = std::atoi(argv[3]);
+    if (argc > 4)
+        options.ticks = std::atoi(argv[4]);
+
+    Config config;
+    if (argc > 5)
+    {
+        std::string error;
+        if (!LoadConfigFile(argv[5], config, &error))
+        {
+            std::fprintf(stderr, "cannot open %s\n", argv[5]);
+            return 2;
+        }
+        if (!error.empty())
+        {
+            std::fprintf(stderr, "%s: %s\n", argv[5], error.c_str());
+            return 2;
+        }
+    }
+    // The plugin runs with the clamped values, so simulate those.
+    for (const auto& fix : ValidateConfig(config))
+        std::printf("config: fixed %s\n", fix.c_str());
+
+    const auto data_path = (std::filesystem::temp_directory_path() / "tribewar_simulate_wars.json").string();
+    std::printf("seed=%llu tribes=%d wars=%d ticks=%d\n", static_cast<unsigned long long>(options.seed), options.tribes,
+                options.wars, options.ticks);
+    const auto report = RunWarSimulation(config, options, data_path);
+    std::error_code ec;
+    std::filesystem::remove(data_path, ec);
+
+    std::printf("%s\n", report.Summary().c_str());
+    for (const auto& violation : report.violations)
+        std::printf("VIOLATION %s\n", violation.c_str());
+    return report.violation_count == 0 ? 0 : 1;
+}
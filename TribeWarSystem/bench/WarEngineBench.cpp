@@ -0,0 +1,176 @@
+// War engine throughput against SimWorld.
+//
+// Builds a server with N tribes (a share of them allied in pairs, some empty)
+// and declares wars between random tribe pairs, then times the engine entry
+// points the plugin calls: war checks, lookups, structure damage, the timer
+// tick, the abandoned-tribe scan and a save/load round trip. Seeded, so runs
+// are comparable between builds.
+//
+// Usage: WarEngineBench [tribes] [wars] [seed]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "SimWorld.h"
+#include "WarEngine.h"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double NsPerOp(Clock::time_point start, Clock::time_point end, size_t ops)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>((std::max)(size_t(1), ops));
+}
+
+void Report(const char* name, size_t ops, double ns)
+{
+    std::printf("%-26s %10zu %12.1f\n", name, ops, ns);
+}
+
+struct Server
+{
+    Config config;
+    SimWorld world;
+    ManualClock clock;
+    std::vector<int64_t> tribe_ids;
+    std::vector<int> structure_classes; // addresses used as opaque class handles
+};
+
+void BuildServer(Server& server, size_t tribes, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    server.config.war_delay_seconds = 60;
+    server.config.cooldown_seconds = 600;
+    server.config.enable_abandoned_structure_window = true;
+    server.config.abandoned_structure_window_seconds = 300;
+    server.config.excluded_structure_blueprints = { "/game/mods/simplespawners/", "/game/extinction/structures/itemballoon/" };
+
+    server.tribe_ids.reserve(tribes);
+    for (size_t i = 0; i < tribes; ++i)
+    {
+        // Sparse 32-bit IDs, like live servers.
+        const int64_t id = static_cast<int64_t>(1000000000u + static_cast<uint32_t>(rng() % 1000000000u));
+        server.tribe_ids.push_back(id);
+        const int32_t members = (rng() % 20 == 0) ? 0 : static_cast<int32_t>(1 + rng() % 8);
+        server.world.tribes.push_back(TribeMembers{ id, members });
+        if (rng() % 3 == 0)
+            server.world.online.insert(id);
+    }
+
+    // One tribe in five is allied with its neighbour.
+    for (size_t i = 0; i + 1 < tribes; i += 5)
+        server.world.Ally(server.tribe_ids[i], server.tribe_ids[i + 1]);
+
+    server.structure_classes.resize(16);
+    for (size_t i = 0; i < server.structure_classes.size(); ++i)
+    {
+        std::string path = "Blueprint'/Game/PrimalEarth/Structures/Wooden/Wall_Wood_" + std::to_string(i) + "_C'";
+        if (i == 0)
+            path = "Blueprint'/Game/Extinction/Structures/ItemBalloon/StorageBox_Balloon.StorageBox_Balloon_C'";
+        server.world.class_paths[&server.structure_classes[i]] = path;
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    const size_t tribes = argc > 1 ? static_cast<size_t>(std::max(2, std::atoi(argv[1]))) : 5000;
+    const size_t wars = argc > 2 ? static_cast<size_t>(std::max(1, std::atoi(argv[2]))) : 200;
+    const uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 42;
+
+    Server server;
+    BuildServer(server, tribes, seed);
+    WarEngine engine(server.world, server.clock, server.config);
+    std::mt19937_64 rng(seed ^ 0x5eed);
+    const auto pick = [&]() { return server.tribe_ids[rng() % server.tribe_ids.size()]; };
+
+    std::printf("tribes=%zu wars=%zu seed=%llu\n", tribes, wars, static_cast<unsigned long long>(seed));
+    std::printf("%-26s %10s %12s\n", "operation", "ops", "ns/op");
+
+    // Declarations: the check runs for every attempt, only allowed pairs declare.
+    size_t attempts = 0;
+    size_t declared = 0;
+    auto start = Clock::now();
+    while (declared < wars && attempts < wars * 50)
+    {
+        ++attempts;
+        const int64_t a = pick();
+        const int64_t b = pick();
+        server.world.online.insert(b);
+        if (engine.CheckWarAllowed(a, b, server.clock.Now()) != WarDenyReason::None)
+            continue;
+        engine.DeclareWar(a, b);
+        ++declared;
+    }
+    Report("check+declare", attempts, NsPerOp(start, Clock::now(), attempts));
+
+    const size_t lookups = 200000;
+    start = Clock::now();
+    size_t found = 0;
+    for (size_t i = 0; i < lookups; ++i)
+        found += engine.GetWarForTribe(pick()).has_value() ? 1 : 0;
+    Report("GetWarForTribe", lookups, NsPerOp(start, Clock::now(), lookups));
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups / 10; ++i)
+        found += engine.GetWarForSide(pick()).has_value() ? 1 : 0;
+    Report("GetWarForSide", lookups / 10, NsPerOp(start, Clock::now(), lookups / 10));
+
+    // Move every war to Active and let the timer announce it.
+    server.clock.Advance(server.config.war_delay_seconds);
+    engine.BeginTick();
+    start = Clock::now();
+    const auto started = engine.ProcessTimers(server.clock.Now());
+    Report("ProcessTimers (start)", 1, NsPerOp(start, Clock::now(), 1));
+
+    const size_t hits = 20000;
+    size_t allowed = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < hits; ++i)
+    {
+        const void* cls = &server.structure_classes[rng() % server.structure_classes.size()];
+        const int64_t target = pick();
+        const int64_t attacker = pick();
+        float mult = 1.0f;
+        allowed += engine.IsStructureDamageAllowed(cls, target, attacker, mult) ? 1 : 0;
+    }
+    Report("IsStructureDamageAllowed", hits, NsPerOp(start, Clock::now(), hits));
+
+    const size_t ticks = 1000;
+    start = Clock::now();
+    for (size_t i = 0; i < ticks; ++i)
+    {
+        engine.BeginTick();
+        engine.ProcessTimers(server.clock.Now());
+    }
+    Report("ProcessTimers (idle)", ticks, NsPerOp(start, Clock::now(), ticks));
+
+    const size_t sweeps = 10;
+    const size_t batches = sweeps * ((tribes + server.config.abandoned_scan_batch - 1) / server.config.abandoned_scan_batch);
+    start = Clock::now();
+    for (size_t i = 0; i < batches; ++i)
+        engine.UpdateAbandonedTribes(server.clock.Now());
+    Report("UpdateAbandonedTribes", batches, NsPerOp(start, Clock::now(), batches));
+
+    const auto path = (std::filesystem::temp_directory_path() / "tribewar_bench_data.json").string();
+    start = Clock::now();
+    engine.SaveData(path);
+    Report("SaveData", 1, NsPerOp(start, Clock::now(), 1));
+    start = Clock::now();
+    engine.LoadData(path, server.clock.Now());
+    Report("LoadData", 1, NsPerOp(start, Clock::now(), 1));
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    std::printf("declared=%zu started_events=%zu lookups_found=%zu damage_allowed=%zu alliance_queries=%llu\n",
+        declared, started.size(), found, allowed, static_cast<unsigned long long>(server.world.alliance_queries));
+    return 0;
+}